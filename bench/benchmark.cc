@@ -0,0 +1,285 @@
+// Benchmark of all engines of make_game_board() across board sizes, initial
+// densities and thread counts.
+//
+// Every configuration is warmed up, then timed over repeated samples of a
+// few generations each. The median and 95th percentile time per generation
+// and the cells updated per second are written as CSV or JSON to stdout, so
+// results can be kept and compared over time; progress goes to stderr.
+//
+// Usage: benchmark [--engines a,b] [--sizes 64,256x128] [--densities 0.5]
+//                  [--threads 1,4] [--warmup N] [--repeats N]
+//                  [--budget-ms N] [--format csv|json]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board_factory.hh"
+
+namespace {
+
+struct BenchOptions {
+  std::vector<std::string> engines;  // All engines if empty
+  std::vector<std::pair<int, int>> sizes = {
+      {64, 64}, {256, 256}, {1024, 1024}, {4096, 4096}, {16384, 16384}};
+  std::vector<double> densities = {0.5};
+  std::vector<int> threads;  // 1 and the hardware threads if empty
+  int warmup = 3;            // Generations run before timing
+  int repeats = 20;          // Samples per configuration
+  // Stop sampling a configuration after this, though every configuration
+  // gets at least one sample
+  int budget_ms = 2000;
+  bool json = false;
+};
+
+struct Result {
+  std::string engine;
+  int x_size, y_size;
+  double density;
+  int threads;
+  // Samples taken, each timing `generations_per_sample` generations
+  int samples;
+  int generations_per_sample;
+  double median_us;  // Per generation
+  double p95_us;     // Per generation
+  double cells_per_second;
+};
+
+std::vector<std::string> split(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    items.push_back(item);
+  }
+  return items;
+}
+
+int parse_int(const std::string& flag, const std::string& value) {
+  char* end = nullptr;
+  long number = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || number < 0 || number > (1 << 30)) {
+    throw std::invalid_argument(flag + " expects a number, got '" + value +
+                                "'");
+  }
+  return number;
+}
+
+BenchOptions parse_bench_options(int argc, char** argv) {
+  BenchOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (i + 1 == argc) {
+      throw std::invalid_argument(flag + " expects a value");
+    }
+    std::string value = argv[++i];
+    if (flag == "--engines") {
+      options.engines = split(value);
+    } else if (flag == "--sizes") {
+      options.sizes.clear();
+      for (const std::string& size : split(value)) {
+        size_t x = size.find('x');
+        int x_size = parse_int(flag, size.substr(0, x));
+        int y_size = x == std::string::npos
+                         ? x_size
+                         : parse_int(flag, size.substr(x + 1));
+        if (x_size == 0 || y_size == 0) {
+          throw std::invalid_argument("Empty board size " + size);
+        }
+        options.sizes.emplace_back(x_size, y_size);
+      }
+    } else if (flag == "--densities") {
+      options.densities.clear();
+      for (const std::string& density : split(value)) {
+        options.densities.push_back(std::stod(density));
+      }
+    } else if (flag == "--threads") {
+      options.threads.clear();
+      for (const std::string& threads : split(value)) {
+        options.threads.push_back(parse_int(flag, threads));
+      }
+    } else if (flag == "--warmup") {
+      options.warmup = parse_int(flag, value);
+    } else if (flag == "--repeats") {
+      options.repeats = std::max(1, parse_int(flag, value));
+    } else if (flag == "--budget-ms") {
+      options.budget_ms = parse_int(flag, value);
+    } else if (flag == "--format") {
+      if (value != "csv" && value != "json") {
+        throw std::invalid_argument("Unknown format " + value);
+      }
+      options.json = value == "json";
+    } else {
+      throw std::invalid_argument("Unknown flag " + flag);
+    }
+  }
+  if (options.engines.empty()) {
+    for (const EngineInfo& engine : engines()) {
+      options.engines.push_back(engine.name);
+    }
+  }
+  if (options.threads.empty()) {
+    options.threads.push_back(1);
+    int hardware = std::thread::hardware_concurrency();
+    if (hardware > 1) {
+      options.threads.push_back(hardware);
+    }
+  }
+  return options;
+}
+
+const EngineInfo& find_engine(const std::string& name) {
+  for (const EngineInfo& engine : engines()) {
+    if (name == engine.name) {
+      return engine;
+    }
+  }
+  throw std::invalid_argument("Unknown engine " + name);
+}
+
+// Time `board` as configured by `options`
+Result run_benchmark(const BenchOptions& options, AbstractGameBoard* board) {
+  typedef std::chrono::steady_clock Clock;
+  auto elapsed_us = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start)
+        .count();
+  };
+  const Clock::time_point bench_start = Clock::now();
+  const double budget_us = options.budget_ms * 1000.0;
+
+  // Warm up, and find how many generations make a sample long enough to be
+  // measured on small boards
+  double warmup_us = 0;
+  int warmup = 0;
+  for (; warmup < options.warmup && elapsed_us(bench_start) < budget_us;
+       warmup++) {
+    Clock::time_point start = Clock::now();
+    board->update();
+    warmup_us = elapsed_us(start);
+  }
+  const double kMinSampleUs = 1000;
+  int generations = warmup_us <= 0
+                        ? 1
+                        : std::max(1, static_cast<int>(kMinSampleUs /
+                                                       warmup_us));
+
+  std::vector<double> samples;
+  while (samples.empty() ||
+         (static_cast<int>(samples.size()) < options.repeats &&
+          elapsed_us(bench_start) < budget_us)) {
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < generations; i++) {
+      board->update();
+    }
+    samples.push_back(elapsed_us(start) / generations);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  Result result;
+  result.samples = samples.size();
+  result.generations_per_sample = generations;
+  size_t n = samples.size();
+  result.median_us = n % 2 ? samples[n / 2]
+                           : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+  result.p95_us = samples[std::max<size_t>((n * 95 + 99) / 100, 1) - 1];
+  std::pair<int, int> size = board->get_board_size();
+  result.cells_per_second =
+      static_cast<double>(size.first) * size.second * 1e6 / result.median_us;
+  return result;
+}
+
+void write_header(const BenchOptions& options) {
+  if (options.json) {
+    std::cout << "[" << std::endl;
+  } else {
+    std::cout << "engine,x_size,y_size,density,threads,samples,"
+                 "generations_per_sample,median_us,p95_us,cells_per_second"
+              << std::endl;
+  }
+}
+
+void write_result(const BenchOptions& options, const Result& result,
+                  bool first) {
+  if (options.json) {
+    std::cout << (first ? "" : ",\n") << "  {\"engine\": \"" << result.engine
+              << "\", \"x_size\": " << result.x_size
+              << ", \"y_size\": " << result.y_size
+              << ", \"density\": " << result.density
+              << ", \"threads\": " << result.threads
+              << ", \"samples\": " << result.samples
+              << ", \"generations_per_sample\": "
+              << result.generations_per_sample
+              << ", \"median_us\": " << result.median_us
+              << ", \"p95_us\": " << result.p95_us
+              << ", \"cells_per_second\": " << result.cells_per_second << "}";
+  } else {
+    std::cout << result.engine << "," << result.x_size << ","
+              << result.y_size << "," << result.density << ","
+              << result.threads << "," << result.samples << ","
+              << result.generations_per_sample << "," << result.median_us
+              << "," << result.p95_us << "," << result.cells_per_second
+              << std::endl;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  try {
+    options = parse_bench_options(argc, argv);
+    for (const std::string& engine : options.engines) {
+      find_engine(engine);
+    }
+  } catch (const std::invalid_argument& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  write_header(options);
+  bool first = true;
+  std::mt19937 random(10808);
+  for (auto [x_size, y_size] : options.sizes) {
+    for (double density : options.densities) {
+      // The same initial state for all engines
+      std::vector<bool> vec(static_cast<uint64_t>(x_size) * y_size);
+      std::bernoulli_distribution alive(density);
+      for (uint64_t i = 0; i < vec.size(); i++) {
+        vec[i] = alive(random);
+      }
+      for (const std::string& name : options.engines) {
+        // Thread counts only matter to multi-threaded engines
+        std::vector<int> threads = options.threads;
+        if (!find_engine(name).threaded) {
+          threads = {1};
+        }
+        for (int num_threads : threads) {
+          std::cerr << name << " " << x_size << "x" << y_size << " density "
+                    << density << " threads " << num_threads << std::endl;
+          std::unique_ptr<AbstractGameBoard> board =
+              make_game_board(name, x_size, y_size, MultiStateRule(),
+                              num_threads);
+          board->read_state_from(vec);
+          Result result = run_benchmark(options, board.get());
+          result.engine = name;
+          result.x_size = x_size;
+          result.y_size = y_size;
+          result.density = density;
+          result.threads = num_threads;
+          write_result(options, result, first);
+          first = false;
+        }
+      }
+    }
+  }
+  if (options.json) {
+    std::cout << "\n]" << std::endl;
+  }
+}
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <new>
 #include <stdexcept>
 #include <vector>
 
@@ -18,6 +22,10 @@ class BitMap {
  public:
   BitMap(int size) : bits_((size - 1) / 64 + 1) {}
   ~BitMap() = default;
+  BitMap(const BitMap&) = default;
+  BitMap(BitMap&&) = default;
+  BitMap& operator=(const BitMap&) = default;
+  BitMap& operator=(BitMap&&) = default;
 
   // Set the bit at position i to 1
   void set(int i) {
@@ -44,35 +52,162 @@ class BitMap {
 
   int report_memory_usage() const { return bits_.size() * sizeof(uint64_t); }
 
+  // Raw access to the packed words, bit i lives in word i / 64
+  uint64_t* data() { return bits_.data(); }
+  const uint64_t* data() const { return bits_.data(); }
+  int size_in_words() const { return bits_.size(); }
+
  private:
   std::vector<uint64_t> bits_;
 };
 
+// Allocator returning memory aligned to `Alignment` bytes
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator {
+  using value_type = T;
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(
+        ::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+  void deallocate(T* p, std::size_t) {
+    ::operator delete(p, std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, Alignment>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U, Alignment>&) const {
+    return false;
+  }
+};
+
+/**
+ * A two dimensional bit map stored in one flat, cache-line aligned buffer.
+ * Row i holds the bits (i, 0) .. (i, y_size - 1) packed like BitMap.
+ *
+ * Every row starts on a 64-byte boundary and rows are `row_stride()` words
+ * apart. To spare the kernels any edge checks, the map is surrounded by
+ * ghost cells that are always zero:
+ *   - row(-1) and row(x_size) are ghost rows,
+ *   - row(i)[-1] and row(i)[words_per_row()] are ghost words.
+ * The bits past y_size in the last word of a row must be kept zero too.
+ *
+ *            [-1]   [0] .. [words-1]  [words]  padding
+ *   row(-1)   0      0  ..    0          0
+ *   row(0)    0      HHHH .. HHHH        0
+ *   ...
+ *   row(x)    0      0  ..    0          0
+ * */
 class TwoDimBitMap {
  public:
-  TwoDimBitMap(int x_size, int y_size) { bits_.resize(x_size, BitMap(y_size)); }
+  TwoDimBitMap(int x_size, int y_size)
+      : x_size_(x_size),
+        y_size_(y_size),
+        words_per_row_((y_size - 1) / 64 + 1),
+        row_stride_(row_stride_for(y_size)),
+        storage_(storage_words(), 0UL),
+        words_(storage_.data()) {}
+  // A map over `storage_words()` words of memory it does not own, e.g. a
+  // file mapped into memory, laid out like the storage of a map of this
+  // size. `owner` keeps the memory alive as long as the map uses it.
+  TwoDimBitMap(int x_size, int y_size, uint64_t* words,
+               std::shared_ptr<void> owner)
+      : x_size_(x_size),
+        y_size_(y_size),
+        words_per_row_((y_size - 1) / 64 + 1),
+        row_stride_(row_stride_for(y_size)),
+        owner_(std::move(owner)),
+        words_(words) {}
   ~TwoDimBitMap() = default;
+  // Copies always own their words
+  TwoDimBitMap(const TwoDimBitMap& other)
+      : x_size_(other.x_size_),
+        y_size_(other.y_size_),
+        words_per_row_(other.words_per_row_),
+        row_stride_(other.row_stride_),
+        storage_(other.words_, other.words_ + other.storage_words()),
+        words_(storage_.data()) {}
+  TwoDimBitMap& operator=(const TwoDimBitMap& other) {
+    TwoDimBitMap copy(other);
+    return *this = std::move(copy);
+  }
+  // Moves only swap the buffer pointer, so boards can flip their buffers
+  // without copying
+  TwoDimBitMap(TwoDimBitMap&&) = default;
+  TwoDimBitMap& operator=(TwoDimBitMap&&) = default;
 
   // Set the bit at position (i, j) to 1
-  void set(int i, int j) { bits_[i].set(j); }
+  void set(int i, int j) {
+    assert(i >= 0 && i < x_size_ && j >= 0 && j < y_size_);
+    row(i)[j / 64] |= (1UL << (j % 64));
+  }
 
   // Set the bit at position (i, j) to 0
-  void clear(int i, int j) { bits_[i].clear(j); }
+  void clear(int i, int j) {
+    assert(i >= 0 && i < x_size_ && j >= 0 && j < y_size_);
+    row(i)[j / 64] &= ~(1UL << (j % 64));
+  }
 
   // Get the value of the bit at position (i, j)
-  bool get(int i, int j) const { return bits_[i].get(j); }
+  bool get(int i, int j) const {
+    assert(i >= 0 && i < x_size_ && j >= 0 && j < y_size_);
+    return row(i)[j / 64] & (1UL << (j % 64));
+  }
 
   // Clear the bit map
-  void clear() {
-    for (auto& bit_map : bits_) bit_map.clear();
-  }
+  void clear() { std::fill(words_, words_ + storage_words(), 0UL); }
 
   int report_memory_usage() const {
-    int total = 0;
-    for (const auto& bit_map : bits_) total += bit_map.report_memory_usage();
-    return total;
+    return storage_words() * sizeof(uint64_t);
+  }
+
+  // Raw access to the packed words of row i, used by the word-level kernels.
+  // i may be -1 or x_size for the ghost rows.
+  uint64_t* row(int i) { return words_ + kLineWords + (i + 1) * row_stride_; }
+  const uint64_t* row(int i) const {
+    return words_ + kLineWords + (i + 1) * row_stride_;
+  }
+  int x_size() const { return x_size_; }
+  int y_size() const { return y_size_; }
+  int words_per_row() const { return words_per_row_; }
+  int row_stride() const { return row_stride_; }
+
+  // The whole storage, ghost cells and padding included, as one block of
+  // storage_words() words starting on a cache line
+  const uint64_t* storage() const { return words_; }
+  uint64_t* storage() { return words_; }
+  size_t storage_words() const { return storage_words_for(x_size_, y_size_); }
+  static size_t storage_words_for(int x_size, int y_size) {
+    return kLineWords + size_t(x_size + 2) * row_stride_for(y_size);
+  }
+  // The row stride of maps with `y_size` columns: room for the two ghost
+  // words, rounded up to whole cache lines
+  static int row_stride_for(int y_size) {
+    return ((y_size - 1) / 64 + 1 + 2 + kLineWords - 1) / kLineWords *
+           kLineWords;
   }
 
  private:
-  std::vector<BitMap> bits_;
-};
\ No newline at end of file
+  // Words per cache line. The first line is only there so that the left
+  // ghost word of row(-1) exists while row(-1) itself stays aligned.
+  static constexpr int kLineWords = 64 / sizeof(uint64_t);
+
+  int x_size_, y_size_;
+  int words_per_row_;  // Words holding the bits of a row
+  int row_stride_;     // Distance between two rows in words
+  // The words, either in `storage_` or in memory kept alive by `owner_`
+  std::vector<uint64_t, AlignedAllocator<uint64_t, 64>> storage_;
+  std::shared_ptr<void> owner_;
+  uint64_t* words_;
+};
@@ -0,0 +1,68 @@
+#include "board_factory.hh"
+
+#include <stdexcept>
+
+#include "hash_life.hh"
+#include "multi_state_game_board.hh"
+#include "sparse_game_board.hh"
+
+const std::vector<EngineInfo>& engines() {
+  static const std::vector<EngineInfo> kEngines = {
+      {"naive", "one bool per cell, updated cell by cell", false, false},
+      {"optimized", "bit map updated cell by cell", false, false},
+      {"threaded", "bit map updated by a thread pool", false, true},
+      {"bitsliced", "bit-sliced adder network, 64 cells per word", false,
+       false},
+      {"lut", "lookup table updating 2x2 blocks", false, false},
+      {"simd", "bit-sliced kernel on the widest vector ISA", false, false},
+      {"tiled", "bit-sliced kernel skipping stable tiles", false, false},
+      {"hashlife", "memoized quadtree", false, false},
+      {"sparse", "unbounded plane of 64x64 chunks", false, false},
+      {"multistate", "Generations and Larger than Life rules", true, false},
+  };
+  return kEngines;
+}
+
+std::unique_ptr<AbstractGameBoard> make_game_board(const std::string& name,
+                                                   int x_size, int y_size,
+                                                   const MultiStateRule& rule,
+                                                   int num_threads) {
+  if (name == "multistate") {
+    return std::make_unique<MultiStateGameBoard>(x_size, y_size, rule);
+  }
+  bool known = false;
+  for (const EngineInfo& engine : engines()) {
+    known |= name == engine.name;
+  }
+  if (!known) {
+    throw std::invalid_argument("Unknown engine " + name);
+  }
+  if (!rule.is_life_like()) {
+    throw std::invalid_argument("Engine " + name + " cannot run " +
+                                rule.to_string() + ", use multistate");
+  }
+  const Rule life_like = rule.to_life_like();
+
+  if (name == "naive") {
+    return std::make_unique<GameBoard>(x_size, y_size, life_like);
+  } else if (name == "optimized") {
+    return std::make_unique<OptimizedGameBoard>(x_size, y_size, life_like);
+  } else if (name == "threaded") {
+    return std::make_unique<FullyOptimizedGameBoard>(x_size, y_size,
+                                                     num_threads, life_like);
+  } else if (name == "bitsliced") {
+    return std::make_unique<BitSlicedGameBoard>(x_size, y_size, life_like);
+  } else if (name == "lut") {
+    return std::make_unique<LutGameBoard>(x_size, y_size, life_like);
+  } else if (name == "simd") {
+    return std::make_unique<SimdGameBoard>(x_size, y_size, best_simd_isa(),
+                                           life_like);
+  } else if (name == "tiled") {
+    return std::make_unique<TiledGameBoard>(x_size, y_size, life_like);
+  } else if (name == "hashlife") {
+    return std::make_unique<HashLifeGameBoard>(x_size, y_size,
+                                               HASHLIFE_MAX_NODES, life_like);
+  } else {
+    return std::make_unique<SparseGameBoard>(x_size, y_size, life_like);
+  }
+}
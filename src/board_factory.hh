@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "game_board.hh"
+
+// An engine make_game_board() can build
+struct EngineInfo {
+  const char* name;
+  const char* description;
+  bool multi_state;  // Whether the engine runs rules that are not Life-like
+  bool threaded;     // Whether the engine uses `num_threads`
+};
+
+// All engines, in the order they are listed to the user
+const std::vector<EngineInfo>& engines();
+
+// Build an `x_size` x `y_size` board of the engine called `name` running
+// `rule`. `num_threads` is only used by the multi-threaded engine, 0 means
+// one thread per hardware thread.
+//
+// Throws std::invalid_argument if there is no such engine or if the engine
+// cannot run `rule`.
+std::unique_ptr<AbstractGameBoard> make_game_board(
+    const std::string& name, int x_size, int y_size,
+    const MultiStateRule& rule = MultiStateRule(), int num_threads = 0);
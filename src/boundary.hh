@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * Boundary policies of the game boards.
+ *
+ * A board templated on a policy keeps a ring of ghost cells around the
+ * board and fills it once per generation, so the inner loop reads the
+ * neighbours of the edge cells without any bounds checks. `source(i, size)`
+ * maps a ghost coordinate along one axis (-1 or `size`) to the coordinate of
+ * the board cell the ghost copies, or to -1 if the ghost is always dead.
+ * Corner ghosts apply the policy to both axes.
+ * */
+
+// Cells outside the board are dead
+struct DeadBoundary {
+  static constexpr bool kDead = true;
+  static constexpr const char* kName = "dead";
+  static int source(int, int) { return -1; }
+};
+
+// The board wraps around: the last row/column is next to the first one
+struct TorusBoundary {
+  static constexpr bool kDead = false;
+  static constexpr const char* kName = "torus";
+  static int source(int i, int size) { return i < 0 ? size - 1 : 0; }
+};
+
+// The board is reflected at its edges: the ghost cells copy the edge cells
+struct MirrorBoundary {
+  static constexpr bool kDead = false;
+  static constexpr const char* kName = "mirror";
+  static int source(int i, int size) { return i < 0 ? 0 : size - 1; }
+};
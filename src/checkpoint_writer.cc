@@ -0,0 +1,151 @@
+#include "checkpoint_writer.hh"
+
+#include "snapshot.hh"
+
+CheckpointWriter::CheckpointWriter(const std::string& path, bool tiles,
+                                   size_t max_bytes,
+                                   Backpressure backpressure)
+    : path_(path),
+      tiles_(tiles),
+      max_bytes_(max_bytes),
+      backpressure_(backpressure),
+      thread_(&CheckpointWriter::run, this) {}
+
+CheckpointWriter::~CheckpointWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queued_.notify_one();
+  thread_.join();
+}
+
+void CheckpointWriter::allocate_frames(int x_size, int y_size) {
+  const size_t frame_bytes =
+      TwoDimBitMap::storage_words_for(x_size, y_size) * sizeof(uint64_t);
+  max_frames_ = max_bytes_ ? std::max<size_t>(1, max_bytes_ / frame_bytes) : 2;
+  frames_.clear();
+  free_.clear();
+  frames_.resize(max_frames_);
+  for (int i = 0; i < max_frames_; i++) {
+    frames_[i].cells.reset(new TwoDimBitMap(x_size, y_size));
+    free_.push_back(i);
+  }
+}
+
+void CheckpointWriter::rethrow_error() {
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+bool CheckpointWriter::submit(const AbstractGameBoard& board,
+                              uint64_t generation) {
+  Rule rule;
+  try {
+    rule = board.get_rule();
+  } catch (const std::logic_error&) {
+    throw std::invalid_argument("Snapshots only hold Life-like boards");
+  }
+  const int64_t start = profile_clock_ns();
+  std::unique_lock<std::mutex> lock(mutex_);
+  rethrow_error();
+  int x_size, y_size;
+  std::tie(x_size, y_size) = board.get_board_size();
+  if (frames_.empty() || frames_[0].cells->x_size() != x_size ||
+      frames_[0].cells->y_size() != y_size) {
+    // Another board: wait until the frames of the old one are written
+    freed_.wait(lock, [this] { return queue_.empty() && !writing_; });
+    allocate_frames(x_size, y_size);
+  }
+  if (free_.empty()) {
+    if (backpressure_ == Backpressure::kSkip) {
+      skipped_++;
+      return false;
+    }
+    freed_.wait(lock, [this] { return !free_.empty(); });
+  }
+  const int index = free_.back();
+  free_.pop_back();
+  const int64_t copy_start = profile_clock_ns();
+  stall_ns_ += copy_start - start;
+  lock.unlock();
+
+  // The frame belongs to this thread until it is queued
+  Frame& frame = frames_[index];
+  copy_cells(board, *frame.cells);
+  frame.rule = rule;
+  frame.generation = generation;
+
+  lock.lock();
+  const int64_t end = profile_clock_ns();
+  copy_ns_ += end - copy_start;
+  stall_ns_ += end - copy_start;
+  queue_.push_back(index);
+  lock.unlock();
+  queued_.notify_one();
+  return true;
+}
+
+void CheckpointWriter::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  freed_.wait(lock, [this] { return queue_.empty() && !writing_; });
+  rethrow_error();
+}
+
+void CheckpointWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;  // Stopped with nothing left to write
+    }
+    const int index = queue_.front();
+    queue_.pop_front();
+    writing_ = true;
+    lock.unlock();
+
+    const Frame& frame = frames_[index];
+    std::exception_ptr error;
+    try {
+      save_snapshot(path_, *frame.cells, frame.rule, frame.generation,
+                    tiles_);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    if (error) {
+      if (!error_) {
+        error_ = error;
+      }
+    } else {
+      written_++;
+    }
+    writing_ = false;
+    free_.push_back(index);
+    freed_.notify_all();
+  }
+}
+
+uint64_t CheckpointWriter::written() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return written_;
+}
+
+uint64_t CheckpointWriter::skipped() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return skipped_;
+}
+
+int64_t CheckpointWriter::stall_ns() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stall_ns_;
+}
+
+int64_t CheckpointWriter::copy_ns() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return copy_ns_;
+}
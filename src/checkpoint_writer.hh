@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game_board.hh"
+
+/**
+ * Saves snapshots of a board on a background thread.
+ *
+ * submit() copies the cells of the board into a free frame, which for a
+ * BitMapGameBoard is one memcpy() of its bit map, and queues it; the writer
+ * thread turns queued frames into snapshot files (see snapshot.hh) while the
+ * simulation goes on. Frames are preallocated and reused, and at most
+ * `max_bytes` of them exist, so the memory held by snapshots in flight is
+ * bounded. When every frame is still queued or being written, submit()
+ * either waits for the writer (kBlock) or drops the snapshot (kSkip).
+ *
+ * All snapshots go to the same path, in the order they were submitted.
+ * Errors of the writer thread are rethrown by the next submit() or flush().
+ * */
+class CheckpointWriter {
+ public:
+  // What submit() does when no frame is free
+  enum class Backpressure { kBlock, kSkip };
+
+  // A `max_bytes` of 0 allows two frames, so one snapshot can be copied
+  // while the previous one is written. At least one frame is always allowed.
+  CheckpointWriter(const std::string& path, bool tiles, size_t max_bytes = 0,
+                   Backpressure backpressure = Backpressure::kBlock);
+  // Writes the snapshots submitted so far, then stops the writer thread
+  ~CheckpointWriter();
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+  // Queue the cells of `board` to be saved as the snapshot after
+  // `generation` generations. Returns false if the snapshot was dropped.
+  bool submit(const AbstractGameBoard& board, uint64_t generation);
+  // Wait until every submitted snapshot is on disk
+  void flush();
+
+  // Frames allowed by the memory bound, known after the first submit()
+  int max_frames() const { return max_frames_; }
+  uint64_t written() const;
+  uint64_t skipped() const;
+  // Time submit() spent waiting for a free frame and copying the board,
+  // i.e. what checkpointing cost the simulation
+  int64_t stall_ns() const;
+  int64_t copy_ns() const;
+
+ private:
+  // A copy of the board waiting to be written
+  struct Frame {
+    std::unique_ptr<TwoDimBitMap> cells;
+    Rule rule;
+    uint64_t generation = 0;
+  };
+
+  void run();  // The writer thread
+  // (Re)allocate the frames for boards of `x_size` x `y_size` cells, with
+  // `mutex_` held and no frame in use
+  void allocate_frames(int x_size, int y_size);
+  // Throw the error of the writer thread, if any, with `mutex_` held
+  void rethrow_error();
+
+  const std::string path_;
+  const bool tiles_;
+  const size_t max_bytes_;
+  const Backpressure backpressure_;
+  int max_frames_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;  // A frame was queued, or stop_ was set
+  std::condition_variable freed_;   // A frame was written
+  std::vector<Frame> frames_;
+  std::vector<int> free_;     // Frames that can be filled
+  std::deque<int> queue_;     // Frames waiting for the writer, oldest first
+  bool writing_ = false;      // Whether the writer holds a frame
+  bool stop_ = false;
+  std::exception_ptr error_;  // The first error of the writer thread
+
+  uint64_t written_ = 0;
+  uint64_t skipped_ = 0;
+  int64_t stall_ns_ = 0;
+  int64_t copy_ns_ = 0;
+
+  std::thread thread_;  // Started last, after everything it uses
+};
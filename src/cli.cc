@@ -0,0 +1,243 @@
+#include "cli.hh"
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include "board_factory.hh"
+
+namespace {
+
+// Parse all of `value` as a number, `flag` names it in errors
+long parse_long(const std::string& flag, const std::string& value) {
+  char* end = nullptr;
+  long number = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0') {
+    throw std::invalid_argument(flag + " expects a number, got '" + value +
+                                "'");
+  }
+  return number;
+}
+
+int parse_positive(const std::string& flag, const std::string& value) {
+  long number = parse_long(flag, value);
+  if (number <= 0 || number > (1 << 30)) {
+    throw std::invalid_argument(flag + " out of range: " + value);
+  }
+  return number;
+}
+
+// Escape `s` as the contents of a JSON string
+std::string json_escape(const std::string& s) {
+  std::string escaped;
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+}  // namespace
+
+Options parse_options(int argc, const char* const* argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    std::string value;
+    bool has_value = false;
+    size_t equals = flag.find('=');
+    if (equals != std::string::npos) {
+      value = flag.substr(equals + 1);
+      flag = flag.substr(0, equals);
+      has_value = true;
+    }
+    // Flags without a value
+    if (flag == "-h" || flag == "--help" || flag == "--headless" ||
+        flag == "--checkpoint-tiles") {
+      if (has_value) {
+        throw std::invalid_argument(flag + " takes no value");
+      }
+      (flag == "--headless"           ? options.headless
+       : flag == "--checkpoint-tiles" ? options.checkpoint_tiles
+                                      : options.help) = true;
+      continue;
+    }
+    if (!has_value) {
+      if (i + 1 == argc) {
+        throw std::invalid_argument(flag + " expects a value");
+      }
+      value = argv[++i];
+    }
+
+    if (flag == "--engine") {
+      options.engine = value;
+    } else if (flag == "--size") {
+      // Either WxH or a single side for square boards
+      size_t x = value.find('x');
+      options.x_size = parse_positive(flag, value.substr(0, x));
+      options.y_size = x == std::string::npos
+                           ? options.x_size
+                           : parse_positive(flag, value.substr(x + 1));
+    } else if (flag == "--rule") {
+      options.rule = value;
+    } else if (flag == "--seed") {
+      options.seed = parse_long(flag, value);
+    } else if (flag == "--density") {
+      char* end = nullptr;
+      options.density = std::strtod(value.c_str(), &end);
+      if (value.empty() || *end != '\0' || options.density < 0 ||
+          options.density > 1) {
+        throw std::invalid_argument("--density expects a number in [0, 1]");
+      }
+    } else if (flag == "--god") {
+      // A comma separated list of god functions
+      std::stringstream list(value);
+      std::string god;
+      while (std::getline(list, god, ',')) {
+        options.gods.push_back(parse_long(flag, god));
+      }
+    } else if (flag == "--pattern") {
+      options.pattern_file = value;
+    } else if (flag == "--at") {
+      size_t comma = value.find(',');
+      if (comma == std::string::npos) {
+        throw std::invalid_argument("--at expects X,Y");
+      }
+      options.pattern_x = parse_long(flag, value.substr(0, comma));
+      options.pattern_y = parse_long(flag, value.substr(comma + 1));
+    } else if (flag == "--save") {
+      options.save_file = value;
+    } else if (flag == "--restore") {
+      options.restore_file = value;
+    } else if (flag == "--checkpoint") {
+      options.checkpoint_file = value;
+    } else if (flag == "--checkpoint-every") {
+      options.checkpoint_every = parse_positive(flag, value);
+    } else if (flag == "--checkpoint-memory") {
+      options.checkpoint_memory_mb = parse_positive(flag, value);
+    } else if (flag == "--generations") {
+      options.generations = parse_positive(flag, value);
+    } else if (flag == "--threads") {
+      options.threads = parse_long(flag, value);
+      if (options.threads < 0) {
+        throw std::invalid_argument("--threads must not be negative");
+      }
+    } else if (flag == "--gens-per-sec") {
+      options.gens_per_sec = parse_long(flag, value);
+      if (options.gens_per_sec < 0) {
+        throw std::invalid_argument("--gens-per-sec must not be negative");
+      }
+    } else if (flag == "--gens-per-frame") {
+      options.gens_per_frame = parse_long(flag, value);
+      if (options.gens_per_frame < 0) {
+        throw std::invalid_argument("--gens-per-frame must not be negative");
+      }
+    } else if (flag == "--metrics") {
+      options.metrics_file = value;
+    } else if (flag == "--metrics-every") {
+      options.metrics_every = parse_positive(flag, value);
+    } else if (flag == "--metrics-sample") {
+      options.metrics_sample = parse_positive(flag, value);
+    } else if (flag == "--format") {
+      if (value == "text") {
+        options.format = OutputFormat::kText;
+      } else if (value == "csv") {
+        options.format = OutputFormat::kCsv;
+      } else if (value == "json") {
+        options.format = OutputFormat::kJson;
+      } else {
+        throw std::invalid_argument("Unknown format " + value);
+      }
+    } else {
+      throw std::invalid_argument("Unknown flag " + flag);
+    }
+  }
+  return options;
+}
+
+std::string usage(const std::string& program) {
+  std::string text =
+      "Usage: " + program +
+      " [flags]\n"
+      "Without flags, all engines are compared against each other.\n"
+      "\n"
+      "  --headless         run without GUI and report the result\n"
+      "  --engine NAME      the game board, see below (default threaded)\n"
+      "  --size WxH         size of the board (default 2048x2048)\n"
+      "  --rule RULE        B3/S23, B2/S/C3, R5,C0,M1,S34..58,B34..45,NM...\n"
+      "  --seed N           seed of the random initial state (default "
+      "10808)\n"
+      "  --density P        probability a cell starts alive (default 0.5)\n"
+      "  --god I[,J...]     apply god functions after seeding\n"
+      "  --pattern FILE     start from a .rle or .cells pattern instead\n"
+      "  --at X,Y           where the pattern goes (default 0,0)\n"
+      "  --save FILE        save the final board as .rle or .cells\n"
+      "  --restore FILE     start from a snapshot, with its size and rule\n"
+      "  --checkpoint FILE  save a snapshot of the board at exit\n"
+      "  --checkpoint-every N\n"
+      "                     also save it every N generations\n"
+      "  --checkpoint-tiles\n"
+      "                     only store the 64x64 tiles with live cells\n"
+      "  --checkpoint-memory MB\n"
+      "                     memory for snapshots being written (default two\n"
+      "                     copies of the board)\n"
+      "  --generations N    generations to run (default 1000)\n"
+      "  --threads N        threads of the threaded engine, 0 for all\n"
+      "  --gens-per-sec N   limit of the GUI, 0 for none (default 0)\n"
+      "  --gens-per-frame N\n"
+      "                     generations per frame of the GUI, 0 for as many\n"
+      "                     as fit (default 0)\n"
+      "  --format FORMAT    text, csv or json (default text)\n"
+      "  --metrics FILE     write per-generation metrics as JSON lines\n"
+      "  --metrics-every N  also write them every N generations\n"
+      "  --metrics-sample N sample the board for them every N generations\n"
+      "                     (default 1)\n"
+      "\n"
+      "Engines:\n";
+  for (const EngineInfo& engine : engines()) {
+    std::string name = engine.name;
+    text += "  " + name + std::string(12 - name.size(), ' ') +
+            engine.description + "\n";
+  }
+  return text;
+}
+
+void write_report(std::ostream& out, const Options& options,
+                  const RunReport& report) {
+  const double ms = report.cpu_time_us / 1000.0;
+  const double gens_per_second =
+      report.cpu_time_us > 0 ? report.generations * 1e6 / report.cpu_time_us
+                             : 0;
+  const std::string size =
+      std::to_string(options.x_size) + "x" + std::to_string(options.y_size);
+  switch (options.format) {
+    case OutputFormat::kText:
+      out << options.engine << " " << size << " " << options.rule << " seed "
+          << options.seed << ": " << report.generations << " generations in "
+          << ms << " ms (" << gens_per_second << " gens/s), population "
+          << report.population << ", " << report.mem_usage
+          << " bytes of memory" << std::endl;
+      break;
+    case OutputFormat::kCsv:
+      // The rule may contain commas, so it is quoted
+      out << "engine,size,rule,seed,generations,cpu_ms,gens_per_second,"
+             "population,mem_bytes\n"
+          << options.engine << "," << size << ",\"" << options.rule << "\","
+          << options.seed << "," << report.generations << "," << ms << ","
+          << gens_per_second << "," << report.population << ","
+          << report.mem_usage << std::endl;
+      break;
+    case OutputFormat::kJson:
+      out << "{\"engine\": \"" << json_escape(options.engine)
+          << "\", \"size\": \"" << size << "\", \"rule\": \""
+          << json_escape(options.rule) << "\", \"seed\": " << options.seed
+          << ", \"generations\": " << report.generations
+          << ", \"cpu_ms\": " << ms
+          << ", \"gens_per_second\": " << gens_per_second
+          << ", \"population\": " << report.population
+          << ", \"mem_bytes\": " << report.mem_usage << "}" << std::endl;
+      break;
+  }
+}
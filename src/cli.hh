@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Formats a headless run can report its result in
+enum class OutputFormat { kText, kCsv, kJson };
+
+// Command line options of the simulator
+struct Options {
+  bool help = false;      // Print the usage and exit
+  bool headless = false;  // Run without ever initializing SDL
+  std::string engine = "threaded";  // See engines()
+  int x_size = 2048, y_size = 2048;
+  std::string rule = "B3/S23";  // Anything MultiStateRule::parse() accepts
+  unsigned seed = 10808;        // Seed of the random initial state
+  double density = 0.5;         // Probability that a cell starts alive
+  std::vector<int> gods;        // God functions applied after seeding
+  // A .rle or .cells pattern placed on an empty board instead of the random
+  // state, with its top left cell at (pattern_x, pattern_y)
+  std::string pattern_file;
+  int pattern_x = 0, pattern_y = 0;
+  std::string save_file;  // Where a headless run saves its final board
+  // A snapshot to start from instead, it sets the size, rule and generation
+  std::string restore_file;
+  // Where a headless run saves a snapshot at exit and, if
+  // `checkpoint_every` is set, every so many generations; as tiles if
+  // `checkpoint_tiles` is set
+  std::string checkpoint_file;
+  int checkpoint_every = 0;
+  bool checkpoint_tiles = false;
+  // Memory for snapshots being written in the background, 0 for two copies
+  // of the board
+  int checkpoint_memory_mb = 0;
+  int generations = 1000;
+  int threads = 0;  // Threads of the multi-threaded engine, 0 for all
+  // Generations per second of an interactive run, 0 for as many as possible
+  int gens_per_sec = 0;
+  // Generations per frame of an interactive run, 0 for as many as fit
+  int gens_per_frame = 0;
+  OutputFormat format = OutputFormat::kText;
+  // Where the per-generation metrics are written as JSON lines, if anywhere,
+  // and every how many generations; the last line is written at exit
+  std::string metrics_file;
+  int metrics_every = 0;
+  // Generations between two samples of the population, the active region
+  // and the memory usage, which cost a pass over the board on most engines
+  int metrics_sample = 1;
+};
+
+// Parse the arguments of main(). Both "--flag value" and "--flag=value" are
+// accepted. Throws std::invalid_argument for unknown flags, missing or
+// malformed values; only the syntax is checked, the engine and the rule are
+// validated when the board is built.
+Options parse_options(int argc, const char* const* argv);
+
+// The help text listing all flags and engines
+std::string usage(const std::string& program);
+
+// The outcome of a headless run
+struct RunReport {
+  int generations;      // Generations simulated
+  int64_t cpu_time_us;  // Time spent in update()
+  uint64_t population;  // Live cells after the last generation
+  int mem_usage;        // Bytes reported by report_mem_usage()
+};
+
+// Write `report` of the run configured by `options` in `options.format`
+void write_report(std::ostream& out, const Options& options,
+                  const RunReport& report);
@@ -1,24 +1,59 @@
 #include "game.hh"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "pixel_kernel.hh"
+
+namespace {
+
+// Pixels per side of a cell at the zoom levels from 0 on
+const int kCellPixels[] = {1, 2, 3, 5, 8, 12, 16, 24, 32};
+const int kZoomLevels = sizeof(kCellPixels) / sizeof(kCellPixels[0]);
+
+}  // namespace
 
 Game::Game(AbstractGameBoard* board,
            std::vector<void (*)(AbstractGameBoard*)> god_functions,
-           bool running, int init_with_god, int stop_at_round)
+           bool running, int init_with_god, uint64_t stop_at_round,
+           bool headless)
     : board_(board),
       cycle_(0),
       running_(running),
       cpu_time_(0),
       stop_at_round_(stop_at_round),
+      headless_(headless),
       gui_(check_GUI()),
-      god_functions_(god_functions) {
+      god_functions_(god_functions),
+      metrics_(0),
+      metrics_out_(nullptr),
+      dump_every_(0),
+      metrics_on_(false),
+      checkpoint_every_(0),
+      gens_per_sec_(0),
+      gens_per_frame_(0),
+      jump_to_(0),
+      measured_gens_per_sec_(0),
+      measured_engine_gens_per_sec_(0),
+      view_width_(
+          std::min(board->get_board_size().first * CELL_SIZE, MAX_VIEW_WIDTH)),
+      view_height_(std::min(board->get_board_size().second * CELL_SIZE,
+                            MAX_VIEW_HEIGHT)),
+      zoom_(0),
+      view_x_(0),
+      view_y_(0),
+      entering_jump_(false) {
+  if (init_with_god && !god_functions_.empty()) {
+    god_functions_[init_with_god % god_functions_.size()](board_);
+  }
+
   if (!gui_) {
-    std::cout << "Board size is too large to fit in the screen, can only run "
-                 "without GUI"
-              << std::endl;
     return;
   }
 
+  fit();
   init_sdl();
 
   // Load font
@@ -28,19 +63,16 @@ Game::Game(AbstractGameBoard* board,
     std::cout << "Failed to load font" << std::endl;
     std::abort();
   }
-
-  if (init_with_god && !god_functions_.empty()) {
-    god_functions_[init_with_god % god_functions_.size()](board_);
-  }
+  text_.reset(new TextCache(renderer_, font_));
 }
 
 Game::~Game() {
   if (!gui_) {
-    std::cout << "We did not initialize SDL, so we don't need to clean up"
-              << std::endl;
     return;
   }
 
+  text_.reset();
+  SDL_DestroyTexture(board_texture_);
   SDL_DestroyRenderer(renderer_);
   SDL_DestroyWindow(window_);
   TTF_CloseFont(font_);
@@ -52,9 +84,14 @@ void Game::init_sdl() {
   SDL_Init(SDL_INIT_VIDEO);
   window_ = SDL_CreateWindow(
       "Game of Life", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-      board_->get_board_size().first * CELL_SIZE + SIDEBAR_WIDTH,
-      board_->get_board_size().second * CELL_SIZE, SDL_WINDOW_SHOWN);
+      view_width_ + SIDEBAR_WIDTH, view_height_, SDL_WINDOW_SHOWN);
   renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED);
+  // Cells are scaled up to their size on screen without blurring
+  SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+  // Large enough for the view at one pixel per cell or block
+  board_texture_ =
+      SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888,
+                        SDL_TEXTUREACCESS_STREAMING, view_width_, view_height_);
 }
 
 void Game::render() {
@@ -68,13 +105,12 @@ void Game::render() {
 }
 
 void Game::draw_sidebar() {
-  SDL_Rect sidebar_rect = {board_->get_board_size().first * CELL_SIZE, 0,
-                           SIDEBAR_WIDTH,
-                           board_->get_board_size().second * CELL_SIZE};
+  SDL_Rect sidebar_rect = {view_width_, 0, SIDEBAR_WIDTH, view_height_};
   SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 255);
   SDL_RenderFillRect(renderer_, &sidebar_rect);
 
   draw_cycle_counts();
+  draw_speed();
   draw_god_function_buttons();
   draw_clear_button();
   draw_start_button();
@@ -82,15 +118,36 @@ void Game::draw_sidebar() {
 
 void Game::draw_cycle_counts() {
   SDL_Color text_color = {255, 255, 255, 255};
-  SDL_Surface* surface = TTF_RenderText_Solid(
-      font_, ("Cycle: \n" + std::to_string(cycle_)).c_str(), text_color);
-  SDL_Texture* cycle_texture = SDL_CreateTextureFromSurface(renderer_, surface);
-  SDL_FreeSurface(surface);
+  SDL_Rect cycle_rect = {view_width_ + 10, 10, SIDEBAR_WIDTH - 20, 30};
+  text_->draw_number("Cycle: ", frames_->front().cycle, text_color,
+                     cycle_rect);
+}
 
-  SDL_Rect cycle_rect = {board_->get_board_size().first * CELL_SIZE + 10, 10,
-                         SIDEBAR_WIDTH - 20, 30};
-  SDL_RenderCopy(renderer_, cycle_texture, NULL, &cycle_rect);
-  SDL_DestroyTexture(cycle_texture);
+void Game::draw_speed() {
+  // The measured rates and the speed setting below the cycle count
+  const Frame& frame = frames_->front();
+  SDL_Color text_color = {255, 255, 255, 255};
+  const int x = view_width_ + 10, width = SIDEBAR_WIDTH - 20;
+  text_->draw_number("Gens/s: ", uint64_t(frame.gens_per_sec + 0.5),
+                     text_color, SDL_Rect{x, 45, width, 25});
+  text_->draw_number("Engine gens/s: ",
+                     uint64_t(frame.engine_gens_per_sec + 0.5), text_color,
+                     SDL_Rect{x, 75, width, 25});
+  if (frame.gens_per_frame > 0) {
+    text_->draw_number("Gens/frame: ", frame.gens_per_frame, text_color,
+                       SDL_Rect{x, 105, width, 25});
+  } else {
+    text_->draw("Gens/frame: max", text_color, SDL_Rect{x, 105, width, 25});
+  }
+  if (entering_jump_) {
+    SDL_Color jump_color = {255, 255, 0, 255};
+    if (jump_digits_.empty()) {
+      text_->draw("Jump to: ", jump_color, SDL_Rect{x, 135, width, 25});
+    } else {
+      text_->draw_number("Jump to: ", std::stoull(jump_digits_), jump_color,
+                         SDL_Rect{x, 135, width, 25});
+    }
+  }
 }
 
 void Game::draw_god_function_buttons() {
@@ -98,40 +155,28 @@ void Game::draw_god_function_buttons() {
   SDL_Color text_color = {255, 255, 255, 255};
   int button_height = 30;
   int button_width = SIDEBAR_WIDTH - 20;
-  int button_y = (board_->get_board_size().second * CELL_SIZE -
-                  god_functions_.size() * button_height) /
-                 2;
+  int button_y =
+      (view_height_ - god_functions_.size() * button_height) / 2;
   for (int i = 0; i < static_cast<int>(god_functions_.size()); i++) {
-    SDL_Rect button_rect = {board_->get_board_size().first * CELL_SIZE + 10,
-                            button_y + i * button_height, button_width,
-                            button_height};
+    SDL_Rect button_rect = {view_width_ + 10, button_y + i * button_height,
+                            button_width, button_height};
     SDL_RenderDrawRect(renderer_, &button_rect);
-    SDL_Surface* surface = TTF_RenderText_Solid(
-        font_, ("God Function " + std::to_string(i)).c_str(), text_color);
-    SDL_Texture* button_texture =
-        SDL_CreateTextureFromSurface(renderer_, surface);
-    SDL_FreeSurface(surface);
-    SDL_Rect button_text_rect = {
-        board_->get_board_size().first * CELL_SIZE + 20,
-        button_y + i * button_height + 5, button_width, button_height};
-    SDL_RenderCopy(renderer_, button_texture, NULL, &button_text_rect);
-    SDL_DestroyTexture(button_texture);
+    SDL_Rect button_text_rect = {view_width_ + 20,
+                                 button_y + i * button_height + 5,
+                                 button_width, button_height};
+    text_->draw("God Function " + std::to_string(i), text_color,
+                button_text_rect);
   }
 }
 
 void Game::draw_clear_button() {
   // Draw a clear button at the top of start/stop button
   SDL_Color text_color = {0, 255, 0, 255};
-  SDL_Rect clear_rect = {
-      board_->get_board_size().first * CELL_SIZE + 10,
-      board_->get_board_size().second * CELL_SIZE - 2 * CTRL_BUTTON_HIGHT,
-      SIDEBAR_WIDTH - 20, CTRL_BUTTON_HIGHT};
+  SDL_Rect clear_rect = {view_width_ + 10,
+                         view_height_ - 2 * CTRL_BUTTON_HIGHT,
+                         SIDEBAR_WIDTH - 20, CTRL_BUTTON_HIGHT};
   SDL_RenderDrawRect(renderer_, &clear_rect);
-  SDL_Surface* surface = TTF_RenderText_Solid(font_, "Clear", text_color);
-  SDL_Texture* clear_texture = SDL_CreateTextureFromSurface(renderer_, surface);
-  SDL_FreeSurface(surface);
-  SDL_RenderCopy(renderer_, clear_texture, NULL, &clear_rect);
-  SDL_DestroyTexture(clear_texture);
+  text_->draw("Clear", text_color, clear_rect);
   // Add a border to the start/stop button, the boarder color is azure
   SDL_SetRenderDrawColor(renderer_, 0, 127, 255, 255);
   SDL_RenderDrawRect(renderer_, &clear_rect);
@@ -140,38 +185,41 @@ void Game::draw_clear_button() {
 void Game::draw_start_button() {
   // Text color: red
   SDL_Color text_color = {255, 0, 0, 255};
-  SDL_Surface* surface;
-  if (running_) {
-    surface = TTF_RenderText_Solid(font_, "Stop", text_color);
-  } else {
-    surface = TTF_RenderText_Solid(font_, "Start", text_color);
-  }
-  SDL_Texture* start_texture = SDL_CreateTextureFromSurface(renderer_, surface);
-  SDL_FreeSurface(surface);
   // Place the start/stop button at the bottom of the sidebar
-  SDL_Rect start_rect = {
-      board_->get_board_size().first * CELL_SIZE + 10,
-      board_->get_board_size().second * CELL_SIZE - CTRL_BUTTON_HIGHT,
-      SIDEBAR_WIDTH - 20, CTRL_BUTTON_HIGHT};
+  SDL_Rect start_rect = {view_width_ + 10, view_height_ - CTRL_BUTTON_HIGHT,
+                         SIDEBAR_WIDTH - 20, CTRL_BUTTON_HIGHT};
 
-  SDL_RenderCopy(renderer_, start_texture, NULL, &start_rect);
-  SDL_DestroyTexture(start_texture);
+  text_->draw(frames_->front().running ? "Stop" : "Start", text_color,
+              start_rect);
   // Add a border to the start/stop button, the boarder color is azure
   SDL_SetRenderDrawColor(renderer_, 0, 127, 255, 255);
   SDL_RenderDrawRect(renderer_, &start_rect);
 }
 
-void Game::draw_board() {
-  SDL_SetRenderDrawColor(renderer_, 255, 255, 255, 255);
-  for (int x = 0; x < board_->get_board_size().first; x++) {
-    for (int y = 0; y < board_->get_board_size().second; y++) {
-      if (board_->get_cell_state(x, y)) {
-        SDL_Rect cell_rect = {x * CELL_SIZE, y * CELL_SIZE, CELL_SIZE,
-                              CELL_SIZE};
-        SDL_RenderFillRect(renderer_, &cell_rect);
-      }
-    }
+void Game::update_board_texture() {
+  // Expand the packed cells straight into the texture, which keeps them until
+  // the next frame comes in
+  const TwoDimBitMap& cells = frames_->front().cells;
+  SDL_Rect rect = {0, 0, cells.x_size(), cells.y_size()};
+  void* pixels;
+  int pitch;
+  if (SDL_LockTexture(board_texture_, &rect, &pixels, &pitch) != 0) {
+    return;
   }
+  render_cells(cells, 0, 0, cells.x_size(), cells.y_size(),
+               static_cast<uint32_t*>(pixels), pitch / sizeof(uint32_t),
+               0xFFFFFFFF, 0xFF000000);
+  SDL_UnlockTexture(board_texture_);
+}
+
+void Game::draw_board() {
+  // Scale the cells of the frame to the board area with a single copy. The
+  // last cells may be cut off by the sidebar, which is drawn on top.
+  const Viewport& view = frames_->front().view;
+  SDL_Rect cells_rect = {0, 0, view.width, view.height};
+  SDL_Rect board_rect = {0, 0, view.width * view.cell_pixels,
+                         view.height * view.cell_pixels};
+  SDL_RenderCopy(renderer_, board_texture_, &cells_rect, &board_rect);
 }
 
 void Game::run() {
@@ -179,67 +227,307 @@ void Game::run() {
     run_without_gui();
     return;
   }
+  // Only the simulation thread touches the board from here on; this one
+  // draws whatever generation it published last, at the frame rate
+  Viewport view = viewport();
+  TwoDimBitMap cells(view.width, view.height);
+  downsample(*board_, view.x0, view.y0, view.shift, cells);
+  frames_.reset(new TripleBuffer<Frame>(
+      Frame{cells, view, cycle_, running_, gens_per_frame_, 0, 0}));
+  views_.reset(new TripleBuffer<Viewport>(view));
+  update_board_texture();
+  std::thread simulation(&Game::simulate, this);
   while (handle_events()) {
-    if (running_) {
-      // count cpu time
-      auto start = std::chrono::high_resolution_clock::now();
-      board_->update();
-      auto end = std::chrono::high_resolution_clock::now();
-      auto duration =
-          std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-      cpu_time_ += duration.count();
-
-      cycle_++;
-      // auto stop at cycle 100
-      if ((int)cycle_ == stop_at_round_) {
+    Uint32 frame_start = SDL_GetTicks();
+    if (frames_->acquire()) {
+      update_board_texture();
+    }
+    render();
+    // Sleep for what is left of the frame budget
+    Uint32 elapsed = SDL_GetTicks() - frame_start;
+    if (elapsed < FRAME_DELAY_MS) {
+      SDL_Delay(FRAME_DELAY_MS - elapsed);
+    }
+  }
+  send(Command{Command::kQuit, 0});
+  simulation.join();
+}
+
+void Game::simulate() {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point next = Clock::now();
+  // Where the current measurement of the rates started
+  Clock::time_point rate_start = next;
+  uint64_t rate_cycle = cycle_;
+  int64_t rate_cpu_time = cpu_time_;
+  int batch = 0;  // Generations since the last frame published
+  // Generations a jump hands to advance() at once, tuned to take about a
+  // frame so the frames and the commands keep coming. advance() matches
+  // update() on every engine, so the chunks do not change where it ends.
+  uint64_t jump_chunk = 1;
+  while (true) {
+    bool changed = views_->acquire();
+    Command command;
+    while (commands_.pop(command)) {
+      if (command.type == Command::kQuit) {
+        return;
+      }
+      execute(command);
+      changed = true;
+    }
+    const bool jumping = running_ && jump_to_ > cycle_;
+    if (!jumping) {
+      jump_chunk = 1;
+    }
+    // With a fixed number of generations per frame, the next batch waits
+    // until the UI thread has picked up the last one
+    const bool waiting = !jumping && gens_per_frame_ > 0 && frames_->pending();
+    if (!running_ || waiting) {
+      if (changed) {
+        publish_frame();
+      }
+      // Nothing to compute until the next command, view or frame
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      next = Clock::now();
+      if (!running_) {
+        measured_gens_per_sec_ = measured_engine_gens_per_sec_ = 0;
+        rate_start = next;
+        rate_cycle = cycle_;
+        rate_cpu_time = cpu_time_;
+      }
+      continue;
+    }
+
+    bool chunked = false;
+    if (jumping && !metrics_on_) {
+      const Clock::time_point start = Clock::now();
+      advance(std::min(jump_chunk, generations_until(jump_to_)));
+      const Clock::duration took = Clock::now() - start;
+      if (took < std::chrono::milliseconds(FRAME_DELAY_MS) / 2) {
+        jump_chunk = std::min(2 * jump_chunk, uint64_t(1) << 62);
+      } else if (took > std::chrono::milliseconds(FRAME_DELAY_MS)) {
+        jump_chunk = std::max<uint64_t>(1, jump_chunk / 2);
+      }
+      chunked = true;
+    } else {
+      step();
+      batch++;
+    }
+    if (jumping) {
+      if (cycle_ == jump_to_) {
         running_ = false;
       }
+    } else if (cycle_ == stop_at_round_) {
+      // auto stop at cycle 100
+      running_ = false;
+    }
+
+    // Measure the rates every half a second
+    const Clock::time_point now = Clock::now();
+    if (now - rate_start >= std::chrono::milliseconds(500)) {
+      const double generations = cycle_ - rate_cycle;
+      measured_gens_per_sec_ =
+          generations / std::chrono::duration<double>(now - rate_start).count();
+      measured_engine_gens_per_sec_ =
+          cpu_time_ > rate_cpu_time
+              ? generations * 1e6 / (cpu_time_ - rate_cpu_time)
+              : 0;
+      rate_start = now;
+      rate_cycle = cycle_;
+      rate_cpu_time = cpu_time_;
+    }
+
+    // Extracting a generation the UI thread would drop unseen is a waste, so
+    // while it has not picked up the last one the view is only extracted if
+    // it must be shown, i.e. the game stopped, the user changed something or
+    // a jump finished a chunk
+    const bool batch_done =
+        !jumping && gens_per_frame_ > 0 ? batch >= gens_per_frame_
+                                        : !frames_->pending();
+    if (changed || !running_ || chunked || batch_done) {
+      publish_frame();
+      batch = 0;
+    }
+
+    if (gens_per_sec_ > 0 && !jumping) {
+      next += std::chrono::nanoseconds(1000000000 / gens_per_sec_);
+      if (next > Clock::now()) {
+        std::this_thread::sleep_until(next);
+      } else {
+        // Behind schedule, do not make up for it with a burst
+        next = Clock::now();
+      }
     }
-    render();
-    SDL_Delay(DELAY_MS);
   }
 }
 
+void Game::execute(const Command& command) {
+  switch (command.type) {
+    case Command::kToggle:
+      running_ = !running_;
+      break;
+    case Command::kClear:
+      board_->clear();
+      cycle_ = 0;
+      running_ = false;
+      jump_to_ = 0;
+      break;
+    case Command::kGod:
+      god_functions_[command.value](board_);
+      break;
+    case Command::kSpeed:
+      gens_per_frame_ = command.value;
+      break;
+    case Command::kJump:
+      // There is no going back
+      if (uint64_t(command.value) > cycle_) {
+        jump_to_ = command.value;
+        running_ = true;
+      }
+      break;
+    case Command::kQuit:
+      break;
+  }
+}
+
+void Game::publish_frame() {
+  const Viewport& view = views_->front();
+  Frame& frame = frames_->back();
+  if (frame.cells.x_size() != view.width ||
+      frame.cells.y_size() != view.height) {
+    frame.cells = TwoDimBitMap(view.width, view.height);
+  }
+  downsample(*board_, view.x0, view.y0, view.shift, frame.cells);
+  frame.view = view;
+  frame.cycle = cycle_;
+  frame.running = running_;
+  frame.gens_per_frame = gens_per_frame_;
+  frame.gens_per_sec = measured_gens_per_sec_;
+  frame.engine_gens_per_sec = measured_engine_gens_per_sec_;
+  frames_->publish();
+}
+
+void Game::send(const Command& command) {
+  // The queue only fills up if the simulation thread is stuck in a huge
+  // generation, so waiting for it is rare
+  while (!commands_.push(command)) {
+    std::this_thread::yield();
+  }
+}
+
+Game::Viewport Game::viewport() const {
+  Viewport view;
+  view.shift = zoom_ < 0 ? -zoom_ : 0;
+  // Blocks start at multiples of their size, so they do not change as the
+  // view moves
+  const int block = 1 << view.shift;
+  view.x0 = std::floor(view_x_ / block) * block;
+  view.y0 = std::floor(view_y_ / block) * block;
+  view.cell_pixels = zoom_ < 0 ? 1 : kCellPixels[zoom_];
+  view.width = (view_width_ + view.cell_pixels - 1) / view.cell_pixels;
+  view.height = (view_height_ + view.cell_pixels - 1) / view.cell_pixels;
+  return view;
+}
+
+double Game::cells_per_pixel() const {
+  return zoom_ < 0 ? double(1 << -zoom_) : 1.0 / kCellPixels[zoom_];
+}
+
+int Game::fit_zoom() const {
+  int x_size, y_size;
+  std::tie(x_size, y_size) = board_->get_board_size();
+  for (int zoom = kZoomLevels - 1;; zoom--) {
+    const int64_t cells = zoom < 0 ? int64_t(1) << -zoom : 1;
+    const int pixels = zoom < 0 ? 1 : kCellPixels[zoom];
+    if (view_width_ / pixels * cells >= x_size &&
+        view_height_ / pixels * cells >= y_size) {
+      return zoom;
+    }
+  }
+}
+
+void Game::fit() {
+  // Like the board used to be drawn if it fits, at CELL_SIZE pixels per cell
+  zoom_ = fit_zoom();
+  while (zoom_ > 0 && kCellPixels[zoom_] > CELL_SIZE) {
+    zoom_--;
+  }
+  view_x_ = view_y_ = 0;
+}
+
+void Game::zoom(int steps, int px, int py) {
+  // Keep the cell under (px, py) where it is
+  const double x = view_x_ + px * cells_per_pixel();
+  const double y = view_y_ + py * cells_per_pixel();
+  zoom_ = std::max(fit_zoom(), std::min(kZoomLevels - 1, zoom_ + steps));
+  view_x_ = x - px * cells_per_pixel();
+  view_y_ = y - py * cells_per_pixel();
+  pan(0, 0);
+}
+
+void Game::pan(double dx, double dy) {
+  // The center of the view stays on the board
+  const double width = view_width_ * cells_per_pixel();
+  const double height = view_height_ * cells_per_pixel();
+  view_x_ = std::max(-width / 2,
+                     std::min(board_->get_board_size().first - width / 2,
+                              view_x_ + dx * cells_per_pixel()));
+  view_y_ = std::max(-height / 2,
+                     std::min(board_->get_board_size().second - height / 2,
+                              view_y_ + dy * cells_per_pixel()));
+  send_view();
+}
+
+void Game::send_view() {
+  views_->back() = viewport();
+  views_->publish();
+}
+
 bool Game::handle_events() {
   SDL_Event event;
   while (SDL_PollEvent(&event)) {
     if (event.type == SDL_QUIT) {
       return false;
+    } else if (event.type == SDL_MOUSEWHEEL) {
+      // Zoom about the mouse
+      int x, y;
+      SDL_GetMouseState(&x, &y);
+      if (x < view_width_ && event.wheel.y != 0) {
+        zoom(event.wheel.y > 0 ? 1 : -1, x, y);
+      }
+    } else if (event.type == SDL_MOUSEMOTION) {
+      // Dragging the board moves the view along
+      if ((event.motion.state & SDL_BUTTON_LMASK) &&
+          event.motion.x < view_width_) {
+        pan(-event.motion.xrel, -event.motion.yrel);
+      }
+    } else if (event.type == SDL_KEYDOWN) {
+      handle_key(event.key.keysym.sym);
     } else if (event.type == SDL_MOUSEBUTTONDOWN) {
       int button_width = SIDEBAR_WIDTH - 20;
       // Clicking on the start/stop button toggles the running state
       int x = event.button.x;
       int y = event.button.y;
-      if ((x >= board_->get_board_size().first * CELL_SIZE &&
-           x <= board_->get_board_size().first * CELL_SIZE + SIDEBAR_WIDTH) &&
-          (y >= board_->get_board_size().second * CELL_SIZE -
-                    CTRL_BUTTON_HIGHT &&
-           y <= board_->get_board_size().second * CELL_SIZE))
-        running_ = !running_;
+      if ((x >= view_width_ && x <= view_width_ + SIDEBAR_WIDTH) &&
+          (y >= view_height_ - CTRL_BUTTON_HIGHT && y <= view_height_))
+        send(Command{Command::kToggle, 0});
 
       // Clicking on the clear button clears the board
-      if ((x >= board_->get_board_size().first * CELL_SIZE &&
-           x <= board_->get_board_size().first * CELL_SIZE + button_width) &&
-          (y >= board_->get_board_size().second * CELL_SIZE -
-                    2 * CTRL_BUTTON_HIGHT &&
-           y <= board_->get_board_size().second * CELL_SIZE -
-                    CTRL_BUTTON_HIGHT)) {
-        board_->clear();
-        cycle_ = 0;
-        running_ = false;
+      if ((x >= view_width_ && x <= view_width_ + button_width) &&
+          (y >= view_height_ - 2 * CTRL_BUTTON_HIGHT &&
+           y <= view_height_ - CTRL_BUTTON_HIGHT)) {
+        send(Command{Command::kClear, 0});
       }
 
       // Clicking on a god function button runs the corresponding function
       int button_height = 30;
-      int button_y = (board_->get_board_size().second * CELL_SIZE -
-                      god_functions_.size() * button_height) /
-                     2;
+      int button_y =
+          (view_height_ - god_functions_.size() * button_height) / 2;
       for (int i = 0; i < static_cast<int>(god_functions_.size()); i++) {
-        if ((x >= board_->get_board_size().first * CELL_SIZE &&
-             x <= board_->get_board_size().first * CELL_SIZE + button_width) &&
+        if ((x >= view_width_ && x <= view_width_ + button_width) &&
             (y >= button_y + i * button_height &&
              y <= button_y + (i + 1) * button_height)) {
-          god_functions_[i](board_);
+          send(Command{Command::kGod, i});
           break;
         }
       }
@@ -248,35 +536,159 @@ bool Game::handle_events() {
   return true;
 }
 
+void Game::handle_key(SDL_Keycode key) {
+  if (entering_jump_) {
+    if (key >= SDLK_0 && key <= SDLK_9 && jump_digits_.size() < 9) {
+      jump_digits_ += char(key);
+    } else if (key == SDLK_BACKSPACE && !jump_digits_.empty()) {
+      jump_digits_.pop_back();
+    } else if (key == SDLK_RETURN || key == SDLK_KP_ENTER) {
+      if (!jump_digits_.empty()) {
+        send(Command{Command::kJump, std::stoll(jump_digits_)});
+      }
+      entering_jump_ = false;
+    } else if (key == SDLK_ESCAPE) {
+      entering_jump_ = false;
+    }
+    return;
+  }
+  const int gens_per_frame = frames_->front().gens_per_frame;
+  switch (key) {
+    case SDLK_LEFT:
+      pan(-view_width_ / 8, 0);
+      break;
+    case SDLK_RIGHT:
+      pan(view_width_ / 8, 0);
+      break;
+    case SDLK_UP:
+      pan(0, -view_height_ / 8);
+      break;
+    case SDLK_DOWN:
+      pan(0, view_height_ / 8);
+      break;
+    case SDLK_PLUS:
+    case SDLK_EQUALS:
+    case SDLK_KP_PLUS:
+      zoom(1, view_width_ / 2, view_height_ / 2);
+      break;
+    case SDLK_MINUS:
+    case SDLK_KP_MINUS:
+      zoom(-1, view_width_ / 2, view_height_ / 2);
+      break;
+    case SDLK_f:
+    case SDLK_HOME:
+      fit();
+      send_view();
+      break;
+    case SDLK_PAGEUP:
+      // 1, 2, 4, ... generations per frame, then as many as possible
+      if (gens_per_frame > 0) {
+        send(Command{Command::kSpeed,
+                     gens_per_frame < MAX_GENS_PER_FRAME ? 2 * gens_per_frame
+                                                         : 0});
+      }
+      break;
+    case SDLK_PAGEDOWN:
+      send(Command{Command::kSpeed, gens_per_frame == 0
+                                        ? MAX_GENS_PER_FRAME
+                                        : std::max(1, gens_per_frame / 2)});
+      break;
+    case SDLK_j:
+      entering_jump_ = true;
+      jump_digits_.clear();
+      break;
+  }
+}
+
 // Must be called with `running_` set to true and `stop_at_round_` set
 void Game::run_without_gui() {
   if (!running_) {
     std::cout << "Error: Game is not running" << std::endl;
     return;
   }
-  if (stop_at_round_ <= 0) {
+  if (stop_at_round_ == 0) {
     std::cout << "Error: stop_at_round_ is not set" << std::endl;
     return;
   }
-  while ((int)cycle_ < stop_at_round_) {
-    // count cpu time
-    auto start = std::chrono::high_resolution_clock::now();
-    board_->update();
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration =
-        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    cpu_time_ += duration.count();
-
-    cycle_++;
+  while (cycle_ < stop_at_round_) {
+    if (metrics_on_) {
+      step();
+    } else {
+      advance(generations_until(stop_at_round_));
+    }
   }
 }
 
-bool Game::check_GUI() {
-  int board_width = board_->get_board_size().first;
-  int board_height = board_->get_board_size().second;
-  if (board_width * CELL_SIZE + SIDEBAR_WIDTH > 3840 ||
-      board_height * CELL_SIZE > 2160) {
-    return false;
+void Game::step() {
+  // count cpu time
+  auto start = std::chrono::high_resolution_clock::now();
+  board_->update();
+  auto end = std::chrono::high_resolution_clock::now();
+  auto duration =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+  cpu_time_ += duration.count() / 1000;
+  metrics_.record_generation(*board_, duration.count());
+
+  cycle_++;
+  if (metrics_out_ && dump_every_ > 0 && cycle_ % dump_every_ == 0) {
+    *metrics_out_ << metrics_.to_json() << std::endl;
   }
-  return true;
-}
\ No newline at end of file
+  if (checkpoint_every_ > 0 && cycle_ % checkpoint_every_ == 0) {
+    checkpoint();
+  }
+}
+
+void Game::advance(uint64_t generations) {
+  auto start = std::chrono::high_resolution_clock::now();
+  board_->advance(generations);
+  auto end = std::chrono::high_resolution_clock::now();
+  cpu_time_ +=
+      std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+          .count();
+
+  cycle_ += generations;
+  if (metrics_out_ && dump_every_ > 0 && cycle_ % dump_every_ == 0) {
+    *metrics_out_ << metrics_.to_json() << std::endl;
+  }
+  if (checkpoint_every_ > 0 && cycle_ % checkpoint_every_ == 0) {
+    checkpoint();
+  }
+}
+
+uint64_t Game::generations_until(uint64_t target) const {
+  uint64_t end = target;
+  if (checkpoint_every_ > 0) {
+    end = std::min(end, (cycle_ / checkpoint_every_ + 1) * checkpoint_every_);
+  }
+  if (metrics_out_ && dump_every_ > 0) {
+    end = std::min(end, (cycle_ / dump_every_ + 1) * dump_every_);
+  }
+  return end - cycle_;
+}
+
+void Game::set_metrics(int sample_every, std::ostream* out, int dump_every) {
+  metrics_on_ = true;
+  metrics_ = Metrics(sample_every);
+  metrics_out_ = out;
+  dump_every_ = dump_every;
+}
+
+void Game::set_checkpoints(const std::string& path, int every, bool tiles,
+                           size_t max_bytes) {
+  checkpoints_.reset(new CheckpointWriter(path, tiles, max_bytes));
+  checkpoint_every_ = every;
+}
+
+void Game::checkpoint() {
+  if (checkpoints_) {
+    checkpoints_->submit(*board_, cycle_);
+  }
+}
+
+void Game::wait_for_checkpoints() {
+  if (checkpoints_) {
+    checkpoints_->flush();
+  }
+}
+
+bool Game::check_GUI() { return !headless_; }
\ No newline at end of file
@@ -3,51 +3,185 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>  // For text rendering
 
+#include <memory>
+#include <string>
+
+#include "bit_map.hh"
+#include "checkpoint_writer.hh"
 #include "game_board.hh"
+#include "metrics.hh"
+#include "spsc_queue.hh"
+#include "text_cache.hh"
+#include "triple_buffer.hh"
 
 #define CELL_SIZE 5
-#define DELAY_MS 100
+#define FRAME_DELAY_MS 16  // Frame budget for about 60 frames per second
 #define SIDEBAR_WIDTH 200
+// Largest board area of the window in pixels, larger boards are zoomed out
+// or panned
+#define MAX_VIEW_WIDTH 1600
+#define MAX_VIEW_HEIGHT 1000
 #define CTRL_BUTTON_HIGHT 100
+#define MAX_GENS_PER_FRAME 1024  // Beyond that, as many as possible
 
 class Game {
  public:
   explicit Game(AbstractGameBoard* board,
                 std::vector<void (*)(AbstractGameBoard*)> god_functions,
-                bool running, int init_with_god, int stop_at_round);
+                bool running, int init_with_god, uint64_t stop_at_round,
+                bool headless = false);
   ~Game();           // Destructor to clean up SDL
-  void run();        // Run the game loop
-  bool check_GUI();  // Check if the game can run with GUI
+  // Run the game loop. With GUI, the generations are computed on a thread of
+  // their own while this one draws the latest of them and handles the input.
+  void run();
+  // Check if the game can run with GUI, i.e. it is not headless. Boards
+  // larger than the window are shown through a viewport that can be zoomed
+  // with the mouse wheel or +/-, panned by dragging or with the arrow keys,
+  // and reset to the whole board with F. Page up and down change the
+  // generations per frame, J followed by a number and enter runs up to that
+  // generation as fast as possible.
+  bool check_GUI();
 
   // Report CPU time in mirco seconds
-  int report_CPU_time() { return cpu_time_; }
+  int64_t report_CPU_time() { return cpu_time_; }
+
+  // Per-generation metrics of the generations run so far
+  const Metrics& metrics() const { return metrics_; }
+  // Sample the board every `sample_every` generations (0 for never), and
+  // write the metrics as one line of JSON to `out` every `dump_every`
+  // generations (0 for never)
+  void set_metrics(int sample_every, std::ostream* out, int dump_every);
+  // Save a snapshot of the board to `path` every `every` generations (0 for
+  // never), as tiles if `tiles` is set (see snapshot.hh). The snapshots are
+  // written in the background with at most `max_bytes` of them in flight,
+  // see CheckpointWriter.
+  void set_checkpoints(const std::string& path, int every, bool tiles,
+                       size_t max_bytes = 0);
+  // Save a snapshot of the current cycle now, in the background
+  void checkpoint();
+  // Wait until the snapshots are on disk. Throws std::runtime_error if one
+  // could not be written.
+  void wait_for_checkpoints();
+  // Count the cycles from `cycle` on, e.g. after restoring a snapshot
+  void resume_at(uint64_t cycle) { cycle_ = cycle; }
+  // Compute at most `gens_per_sec` generations per second with GUI, 0 for
+  // as many as possible
+  void set_gens_per_sec(int gens_per_sec) { gens_per_sec_ = gens_per_sec; }
+  // Compute `gens_per_frame` generations for every frame drawn with GUI, 0
+  // for as many as the simulation thread gets done in between
+  void set_gens_per_frame(int gens_per_frame) {
+    gens_per_frame_ = gens_per_frame;
+  }
 
  private:
   AbstractGameBoard* board_;  // The game board
   SDL_Window* window_;        // The SDL window
   SDL_Renderer* renderer_;    // The SDL renderer
+  SDL_Texture* board_texture_;  // One pixel per cell, streamed every frame
   TTF_Font* font_;            // a font to render text
+  std::unique_ptr<TextCache> text_;  // The sidebar text rendered so far
 
-  uint cycle_;         // The current cycle of the game
-  bool running_;       // Whether the game is running
-  int64_t cpu_time_;   // accumulate the CPU time in micro seconds
-  int stop_at_round_;  // stop the game at this round
-  bool gui_;           // Whether the game is running with GUI
+  uint64_t cycle_;          // The current cycle of the game
+  bool running_;            // Whether the game is running
+  int64_t cpu_time_;        // accumulate the CPU time in micro seconds
+  uint64_t stop_at_round_;  // stop the game at this round
+  bool headless_;           // Whether the GUI was turned off by the caller
+  bool gui_;                // Whether the game is running with GUI
 
   // a set of god functions. The god function takes a GameBoard*
   // as an argument and modifies the board state in some patterns.
   std::vector<void (*)(AbstractGameBoard*)> god_functions_;
 
-  void init_sdl();       // Initialize SDL
-  void render();         // Render the current board state
-  bool handle_events();  // Handle SDL events
+  Metrics metrics_;              // Metrics of every generation
+  std::ostream* metrics_out_;    // Where the metrics are dumped, if anywhere
+  int dump_every_;               // Generations between two dumps
+  // Whether set_metrics() was called, so every generation must be recorded
+  bool metrics_on_;
+
+  // Saves the snapshots, if there are any
+  std::unique_ptr<CheckpointWriter> checkpoints_;
+  int checkpoint_every_;  // Generations between two snapshots
+
+  // Input of the UI thread for the simulation thread
+  struct Command {
+    enum Type { kToggle, kClear, kGod, kSpeed, kJump, kQuit } type;
+    // The god function of kGod, the generations per frame of kSpeed, or
+    // the cycle to run up to of kJump
+    int64_t value;
+  };
+  // The region of the board on screen
+  struct Viewport {
+    int x0, y0;         // The cell at the top left corner
+    int shift;          // Blocks of 2^shift x 2^shift cells make one pixel
+    int cell_pixels;    // Pixels per side of a cell or block
+    int width, height;  // Cells or blocks across the view
+  };
+  // A generation handed from the simulation thread to the UI thread: only
+  // the cells in view, downsampled to one bit per block
+  struct Frame {
+    TwoDimBitMap cells;
+    Viewport view;
+    uint64_t cycle;
+    bool running;
+    int gens_per_frame;
+    double gens_per_sec;         // Measured over the last half second
+    double engine_gens_per_sec;  // The same over the time in update()
+  };
+
+  int gens_per_sec_;    // Limit of the simulation thread, 0 for none
+  int gens_per_frame_;  // Generations per frame drawn, 0 for any number
+  uint64_t jump_to_;    // The cycle to run up to at full speed, if past
+  // The measured rates, owned by the simulation thread
+  double measured_gens_per_sec_, measured_engine_gens_per_sec_;
+  SpscQueue<Command, 64> commands_;              // From the UI thread
+  std::unique_ptr<TripleBuffer<Frame>> frames_;  // To the UI thread
+  // The latest view, to the simulation thread. Unlike the commands, views
+  // replace each other, so panning never waits for a slow generation.
+  std::unique_ptr<TripleBuffer<Viewport>> views_;
+
+  int view_width_, view_height_;  // Pixels of the board area
+  // Index into the cell sizes of game.cc, or -shift when zoomed out further
+  int zoom_;
+  double view_x_, view_y_;  // The cell at the top left corner of the view
+  // Whether a cycle to jump to is being typed, and its digits so far
+  bool entering_jump_;
+  std::string jump_digits_;
+
+  void init_sdl();                    // Initialize SDL
+  void render();                      // Render the latest frame
+  bool handle_events();               // Turn SDL events into commands
+  void handle_key(SDL_Keycode key);   // Turn a key press into commands
+  void send(const Command& command);  // Queue a command, waiting for room
+
+  void simulate();                       // The simulation thread
+  void execute(const Command& command);  // Run a command on the board
+  void publish_frame();                  // Hand the board to the UI thread
+
+  Viewport viewport() const;             // The view at the current zoom
+  double cells_per_pixel() const;        // At the current zoom
+  int fit_zoom() const;                  // The closest zoom showing it all
+  void fit();                            // Show the whole board
+  void zoom(int steps, int px, int py);  // Zoom in about pixel (px, py)
+  void pan(double dx, double dy);        // Move the view by pixels
+  void send_view();  // Hand the view to the simulation thread
 
+  void update_board_texture();  // Stream the cells of the latest frame
   void draw_board();
   void draw_sidebar();
   void draw_cycle_counts();
+  void draw_speed();
   void draw_god_function_buttons();
   void draw_clear_button();
   void draw_start_button();
 
   void run_without_gui();  // Run the game loop without GUI
+  void step();             // Compute the next generation and record it
+  // Compute `generations` generations at once with advance(), which lets
+  // engines like HashLife skip ahead. The metrics are not recorded, so it
+  // is only used while they are off; advance() matches update() on every
+  // engine, so turning them on does not change the generations computed.
+  void advance(uint64_t generations);
+  // The generations from the current cycle up to `target`, or up to the
+  // next snapshot or metrics dump if that comes first
+  uint64_t generations_until(uint64_t target) const;
 };
\ No newline at end of file
@@ -1,6 +1,25 @@
 #include "game_board.hh"
 
-#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "life_kernel.hh"
+
+// The packed layout is defined in little-endian bytes, which lets the bit
+// map boards copy their words as they are
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "The packed layout assumes a little-endian host");
+
+// Throw unless a buffer of `size` bytes holds the `expected` bytes of a
+// packed board
+static void check_packed_size(size_t size, size_t expected) {
+  if (size != expected) {
+    throw std::invalid_argument("Expected " + std::to_string(expected) +
+                                " bytes of packed cells, got " +
+                                std::to_string(size));
+  }
+}
 
 bool AbstractGameBoard::operator==(const AbstractGameBoard& other) const {
   auto [x_size, y_size] = get_board_size();
@@ -8,9 +27,15 @@ bool AbstractGameBoard::operator==(const AbstractGameBoard& other) const {
       y_size != other.get_board_size().second) {
     return false;
   }
+  auto bit_map = dynamic_cast<const BitMapGameBoard*>(this);
+  auto other_bit_map = dynamic_cast<const BitMapGameBoard*>(&other);
+  if (bit_map && other_bit_map) {
+    return bit_map->same_cells(*other_bit_map);
+  }
+  const int words = packed_row_words();
   for (int x = 0; x < x_size; x++) {
-    for (int y = 0; y < y_size; y++) {
-      if (get_cell_state(x, y) != other.get_cell_state(x, y)) {
+    for (int k = 0; k < words; k++) {
+      if (get_word(x, k) != other.get_word(x, k)) {
         return false;
       }
     }
@@ -18,96 +43,211 @@ bool AbstractGameBoard::operator==(const AbstractGameBoard& other) const {
   return true;
 }
 
-GameBoard::GameBoard(int x_size, int y_size)
+uint64_t AbstractGameBoard::get_word(int x, int k) const {
+  const int y_end = std::min(get_board_size().second, (k + 1) * 64);
+  uint64_t word = 0;
+  for (int y = k * 64; y < y_end; y++) {
+    word |= static_cast<uint64_t>(get_cell_state(x, y)) << (y % 64);
+  }
+  return word;
+}
+
+void AbstractGameBoard::set_word(int x, int k, uint64_t word) {
+  const int y_end = std::min(get_board_size().second, (k + 1) * 64);
+  for (int y = k * 64; y < y_end; y++) {
+    set_cell_state(x, y, (word >> (y % 64)) & 1);
+  }
+}
+
+void AbstractGameBoard::import_bytes(const uint8_t* bytes, size_t size) {
+  const int x_size = get_board_size().first, words = packed_row_words();
+  check_packed_size(size, size_t(x_size) * words * sizeof(uint64_t));
+  for (int x = 0; x < x_size; x++) {
+    for (int k = 0; k < words; k++) {
+      uint64_t word;
+      std::memcpy(&word, bytes + (size_t(x) * words + k) * 8, 8);
+      set_word(x, k, word);
+    }
+  }
+}
+
+void AbstractGameBoard::export_bytes(uint8_t* bytes, size_t size) const {
+  const int x_size = get_board_size().first, words = packed_row_words();
+  check_packed_size(size, size_t(x_size) * words * sizeof(uint64_t));
+  for (int x = 0; x < x_size; x++) {
+    for (int k = 0; k < words; k++) {
+      uint64_t word = get_word(x, k);
+      std::memcpy(bytes + (size_t(x) * words + k) * 8, &word, 8);
+    }
+  }
+}
+
+void AbstractGameBoard::import_words(const std::vector<uint64_t>& words) {
+  import_bytes(reinterpret_cast<const uint8_t*>(words.data()),
+               words.size() * sizeof(uint64_t));
+}
+
+std::vector<uint64_t> AbstractGameBoard::export_words() const {
+  std::vector<uint64_t> words(size_t(get_board_size().first) *
+                              packed_row_words());
+  export_bytes(reinterpret_cast<uint8_t*>(words.data()),
+               words.size() * sizeof(uint64_t));
+  return words;
+}
+
+uint64_t AbstractGameBoard::population() const {
+  auto [x_size, y_size] = get_board_size();
+  uint64_t count = 0;
+  for (int x = 0; x < x_size; x++) {
+    for (int y = 0; y < y_size; y++) {
+      count += get_cell_state(x, y);
+    }
+  }
+  return count;
+}
+
+uint64_t AbstractGameBoard::active_cells() const {
+  auto [x_size, y_size] = get_board_size();
+  return static_cast<uint64_t>(x_size) * y_size;
+}
+
+BoundingBox AbstractGameBoard::bounding_box() const {
+  auto [x_size, y_size] = get_board_size();
+  BoundingBox box;
+  for (int x = 0; x < x_size; x++) {
+    for (int y = 0; y < y_size; y++) {
+      if (get_cell_state(x, y)) {
+        box.add(x, y);
+      }
+    }
+  }
+  return box;
+}
+
+template <typename Boundary>
+BasicGameBoard<Boundary>::BasicGameBoard(int x_size, int y_size,
+                                         const Rule& rule)
     : x_size_(x_size),
       y_size_(y_size),
-      cells_(x_size, std::vector<bool>(y_size, false)) {}
+      rule_(rule),
+      cells_(2 * (x_size + 2) * (y_size + 2), false),
+      front_(0) {}
 
-void GameBoard::clear() {
+template <typename Boundary>
+void BasicGameBoard<Boundary>::clear() {
   for (int x = 0; x < x_size_; x++) {
     for (int y = 0; y < y_size_; y++) {
-      cells_[x][y] = false;
+      cells_[index(x, y)] = false;
     }
   }
 }
 
-void GameBoard::set_cell_state(int x, int y, bool state) {
-  cells_[x][y] = state;
+template <typename Boundary>
+void BasicGameBoard<Boundary>::set_cell_state(int x, int y, bool state) {
+  cells_[index(x, y)] = state;
 }
 
-bool GameBoard::get_cell_state(int x, int y) const { return cells_[x][y]; }
+template <typename Boundary>
+bool BasicGameBoard<Boundary>::get_cell_state(int x, int y) const {
+  return cell(x, y);
+}
 
-void GameBoard::read_state_from(std::vector<bool>& vec) {
+template <typename Boundary>
+void BasicGameBoard<Boundary>::read_state_from(std::vector<bool>& vec) {
   assert(vec.size() == (uint64_t)(x_size_ * y_size_));
   int idx = 0;
   for (int i = 0; i < x_size_; i++) {
     for (int j = 0; j < y_size_; j++) {
-      cells_[i][j] = vec[idx++];
+      cells_[index(i, j)] = vec[idx];
+      idx++;
     }
   }
 }
 
-std::pair<int, int> GameBoard::get_board_size() const {
+template <typename Boundary>
+std::pair<int, int> BasicGameBoard<Boundary>::get_board_size() const {
   return std::make_pair(x_size_, y_size_);
 }
 
-void GameBoard::update() {
-  std::vector<std::vector<bool>> new_cells(x_size_, std::vector<bool>(y_size_));
+// The ghost ring of a dead boundary is never written, so it stays dead
+template <typename Boundary>
+void BasicGameBoard<Boundary>::fill_ghost_cells() {
+  if (Boundary::kDead) {
+    return;
+  }
+  auto fill = [this](int x, int y) {
+    const int src_x = x < 0 || x == x_size_ ? Boundary::source(x, x_size_) : x;
+    const int src_y = y < 0 || y == y_size_ ? Boundary::source(y, y_size_) : y;
+    cells_[index(x, y)] = cell(src_x, src_y);
+  };
   for (int x = 0; x < x_size_; x++) {
-    for (int y = 0; y < y_size_; y++) {
-      new_cells[x][y] = calculate_next_state(x, y);
-    }
+    fill(x, -1);
+    fill(x, y_size_);
+  }
+  for (int y = -1; y <= y_size_; y++) {
+    fill(-1, y);
+    fill(x_size_, y);
   }
-  cells_ = new_cells;
 }
 
-int GameBoard::count_live_neighbors(int x, int y) {
-  int count = 0;
-  for (int i = -1; i <= 1; i++) {
-    for (int j = -1; j <= 1; j++) {
-      if (i == 0 && j == 0) {
-        continue;
-      }
-      int new_x = x + i;
-      int new_y = y + j;
-      if (new_x < 0 || new_x >= x_size_ || new_y < 0 || new_y >= y_size_) {
-        continue;
-      }
-      if (cells_[new_x][new_y]) {
-        count++;
-      }
+template <typename Boundary>
+void BasicGameBoard<Boundary>::update() {
+  fill_ghost_cells();
+  const int back = front_ == 0 ? (x_size_ + 2) * (y_size_ + 2) : 0;
+  for (int x = 0; x < x_size_; x++) {
+    for (int y = 0; y < y_size_; y++) {
+      cells_[index(x, y) - front_ + back] = calculate_next_state(x, y);
     }
   }
-  return count;
+  front_ = back;
 }
 
-bool GameBoard::calculate_next_state(int x, int y) {
-  int live_neighbors = count_live_neighbors(x, y);
-  if (cells_[x][y]) {
-    return live_neighbors == 2 || live_neighbors == 3;
-  } else {
-    return live_neighbors == 3;
-  }
+template <typename Boundary>
+int BasicGameBoard<Boundary>::count_live_neighbors(int x, int y) {
+  return cell(x - 1, y - 1) + cell(x - 1, y) + cell(x - 1, y + 1) +
+         cell(x, y - 1) + cell(x, y + 1) + cell(x + 1, y - 1) +
+         cell(x + 1, y) + cell(x + 1, y + 1);
+}
+
+template <typename Boundary>
+bool BasicGameBoard<Boundary>::calculate_next_state(int x, int y) {
+  return rule_.next_state(cell(x, y), count_live_neighbors(x, y));
+}
+
+template <typename Boundary>
+int BasicGameBoard<Boundary>::report_mem_usage() {
+  return 2 * (x_size_ + 2) * (y_size_ + 2) * sizeof(bool);
 }
 
-int GameBoard::report_mem_usage() { return x_size_ * y_size_ * sizeof(bool); }
+template class BasicGameBoard<DeadBoundary>;
+template class BasicGameBoard<TorusBoundary>;
+template class BasicGameBoard<MirrorBoundary>;
 
 // ---------------------------------------------------------------------------
-//                   OptimizedGameBoard
+//                   BitMapGameBoard
 // ---------------------------------------------------------------------------
 
-OptimizedGameBoard::OptimizedGameBoard(int x_size, int y_size)
-    : x_size_(x_size), y_size_(y_size), cells_(x_size, y_size) {}
+BitMapGameBoard::BitMapGameBoard(int x_size, int y_size, const Rule& rule)
+    : x_size_(x_size),
+      y_size_(y_size),
+      rule_(rule),
+      cells_(x_size, y_size),
+      next_cells_(x_size, y_size),
+      population_(0),
+      population_valid_(true) {}
 
-std::pair<int, int> OptimizedGameBoard::get_board_size() const {
+std::pair<int, int> BitMapGameBoard::get_board_size() const {
   return std::make_pair(x_size_, y_size_);
 }
 
-bool OptimizedGameBoard::get_cell_state(int x, int y) const {
+bool BitMapGameBoard::get_cell_state(int x, int y) const {
   return cells_.get(x, y);
 }
 
-void OptimizedGameBoard::set_cell_state(int x, int y, bool state) {
+void BitMapGameBoard::set_cell_state(int x, int y, bool state) {
+  if (population_valid_ && cells_.get(x, y) != state) {
+    population_ += state ? 1 : -1;
+  }
   if (state) {
     cells_.set(x, y);
   } else {
@@ -115,157 +255,550 @@ void OptimizedGameBoard::set_cell_state(int x, int y, bool state) {
   }
 }
 
-void OptimizedGameBoard::read_state_from(std::vector<bool>& vec) {
+void BitMapGameBoard::read_state_from(std::vector<bool>& vec) {
   assert(vec.size() == (uint64_t)(x_size_ * y_size_));
-  int idx = 0;
+  // Assemble whole words rather than setting the cells one by one
+  size_t idx = 0;
   for (int i = 0; i < x_size_; i++) {
-    for (int j = 0; j < y_size_; j++) {
-      if (vec[idx++]) {
-        cells_.set(i, j);
+    uint64_t* row = cells_.row(i);
+    for (int k = 0; k < cells_.words_per_row(); k++) {
+      const int bits = std::min(64, y_size_ - k * 64);
+      uint64_t word = 0;
+      for (int b = 0; b < bits; b++) {
+        word |= static_cast<uint64_t>(vec[idx++]) << b;
       }
+      row[k] |= word;
     }
   }
+  population_valid_ = false;
 }
 
-void OptimizedGameBoard::update() {
-  TwoDimBitMap next_cells(x_size_, y_size_);
+void BitMapGameBoard::set_word(int x, int k, uint64_t word) {
+  uint64_t& old = cells_.row(x)[k];
+  word &= word_mask(k);
+  if (population_valid_) {
+    population_ += __builtin_popcountll(word);
+    population_ -= __builtin_popcountll(old);
+  }
+  old = word;
+}
+
+// The rows of the bit map are the rows of the packed layout, apart from
+// the ghost words and the padding between them
+void BitMapGameBoard::import_bytes(const uint8_t* bytes, size_t size) {
+  const int words = cells_.words_per_row();
+  const size_t row_bytes = words * sizeof(uint64_t);
+  check_packed_size(size, x_size_ * row_bytes);
   for (int i = 0; i < x_size_; i++) {
-    for (int j = 0; j < y_size_; j++) {
-      if (calculate_next_state(i, j)) {
-        next_cells.set(i, j);
-      } else {
-        next_cells.clear(i, j);
-      }
-    }
+    uint64_t* row = cells_.row(i);
+    std::memcpy(row, bytes + i * row_bytes, row_bytes);
+    row[words - 1] &= word_mask(words - 1);
   }
-  cells_ = next_cells;
+  population_valid_ = false;
 }
 
-void OptimizedGameBoard::clear() { cells_.clear(); }
+void BitMapGameBoard::adopt_cells(TwoDimBitMap&& cells) {
+  if (cells.x_size() != x_size_ || cells.y_size() != y_size_) {
+    throw std::invalid_argument("Cannot adopt cells of another size");
+  }
+  cells_ = std::move(cells);
+  population_valid_ = false;
+}
 
-int OptimizedGameBoard::count_live_neighbors(int x, int y) {
-  int count = 0;
-  for (int i = -1; i <= 1; i++) {
-    for (int j = -1; j <= 1; j++) {
-      if (i == 0 && j == 0) {
-        continue;
-      }
-      int new_x = x + i;
-      int new_y = y + j;
-      if (new_x < 0 || new_x >= x_size_ || new_y < 0 || new_y >= y_size_) {
-        continue;
-      }
-      if (cells_.get(new_x, new_y)) {
-        count++;
-      }
+void BitMapGameBoard::export_bytes(uint8_t* bytes, size_t size) const {
+  const size_t row_bytes = cells_.words_per_row() * sizeof(uint64_t);
+  check_packed_size(size, x_size_ * row_bytes);
+  for (int i = 0; i < x_size_; i++) {
+    std::memcpy(bytes + i * row_bytes, cells_.row(i), row_bytes);
+  }
+}
+
+bool BitMapGameBoard::same_cells(const BitMapGameBoard& other) const {
+  if (x_size_ != other.x_size_ || y_size_ != other.y_size_) {
+    return false;
+  }
+  const size_t row_bytes = cells_.words_per_row() * sizeof(uint64_t);
+  for (int i = 0; i < x_size_; i++) {
+    if (std::memcmp(cells_.row(i), other.cells_.row(i), row_bytes) != 0) {
+      return false;
     }
   }
-  return count;
+  return true;
+}
+
+void BitMapGameBoard::clear() {
+  cells_.clear();
+  population_ = 0;
+  population_valid_ = true;
 }
 
-bool OptimizedGameBoard::calculate_next_state(int x, int y) {
-  int live_neighbors = count_live_neighbors(x, y);
-  if (cells_.get(x, y)) {
-    return live_neighbors == 2 || live_neighbors == 3;
+uint64_t BitMapGameBoard::population() const {
+  if (!population_valid_) {
+    population_ = 0;
+    for (int i = 0; i < x_size_; i++) {
+      population_ += popcount_words(cells_.row(i), cells_.words_per_row());
+    }
+    population_valid_ = true;
   }
-  return live_neighbors == 3;
+  return population_;
 }
 
-int OptimizedGameBoard::report_mem_usage() {
-  return cells_.report_memory_usage();
+BoundingBox BitMapGameBoard::bounding_box() const {
+  const int words = cells_.words_per_row();
+  BoundingBox box;
+  // The union of all rows tells the columns, the first and the last row
+  // with a live cell tell the rows
+  std::vector<uint64_t> columns(words, 0);
+  for (int i = 0; i < x_size_; i++) {
+    const uint64_t* row = cells_.row(i);
+    uint64_t any = 0;
+    for (int k = 0; k < words; k++) {
+      columns[k] |= row[k];
+      any |= row[k];
+    }
+    if (any) {
+      box.x_min = std::min(box.x_min, i);
+      box.x_max = i;
+    }
+  }
+  for (int k = 0; k < words; k++) {
+    if (columns[k]) {
+      box.y_min = std::min(box.y_min, k * 64 + __builtin_ctzll(columns[k]));
+      box.y_max = k * 64 + 63 - __builtin_clzll(columns[k]);
+    }
+  }
+  return box;
 }
 
-// ---------------------------------------------------------------------------
-//                             Fully Optimized GameBoard
-// ---------------------------------------------------------------------------
+std::vector<uint32_t> BitMapGameBoard::row_population() const {
+  std::vector<uint32_t> rows(x_size_);
+  for (int i = 0; i < x_size_; i++) {
+    rows[i] = popcount_words(cells_.row(i), cells_.words_per_row());
+  }
+  return rows;
+}
 
-FullyOptimizedGameBoard::FullyOptimizedGameBoard(int x_size, int y_size)
-    : x_size_(x_size), y_size_(y_size), cells_(x_size, y_size) {}
+std::vector<uint32_t> BitMapGameBoard::tile_population() const {
+  const int words = cells_.words_per_row();
+  std::vector<uint32_t> tiles((x_size_ + 63) / 64 * words, 0);
+  for (int i = 0; i < x_size_; i++) {
+    popcount_add(cells_.row(i), words, tiles.data() + i / 64 * words);
+  }
+  return tiles;
+}
 
-std::pair<int, int> FullyOptimizedGameBoard::get_board_size() const {
-  return std::make_pair(x_size_, y_size_);
+// The ghost rows and words around the map, as well as the bits past the
+// last cell of a row, are dead, so the neighbours of the edge cells can be
+// read without bounds checks
+int BitMapGameBoard::count_live_neighbors(int x, int y) {
+  int count = 0;
+  for (int i = -1; i <= 1; i++) {
+    const uint64_t* row = cells_.row(x + i);
+    for (int j = y - 1; j <= y + 1; j++) {
+      // j >> 6 rounds towards negative infinity, so j == -1 is the last bit
+      // of the ghost word at [-1]
+      count += (row[j >> 6] >> (j & 63)) & 1;
+    }
+  }
+  return count - cells_.get(x, y);
 }
 
-bool FullyOptimizedGameBoard::get_cell_state(int x, int y) const {
-  return cells_.get(x, y);
+template <typename Boundary>
+void BitMapGameBoard::fill_ghost_cells() {
+  if (Boundary::kDead) {
+    return;
+  }
+  const int words = cells_.words_per_row();
+  const int low = Boundary::source(-1, y_size_);
+  const int high = Boundary::source(y_size_, y_size_);
+  for (int i = 0; i < x_size_; i++) {
+    uint64_t* row = cells_.row(i);
+    row[-1] = static_cast<uint64_t>(cells_.get(i, low)) << 63;
+    row[y_size_ / 64] |= static_cast<uint64_t>(cells_.get(i, high))
+                         << (y_size_ % 64);
+  }
+  // The ghost rows copy whole rows including their ghost words, which takes
+  // care of the corners
+  const uint64_t* first = cells_.row(Boundary::source(-1, x_size_));
+  const uint64_t* last = cells_.row(Boundary::source(x_size_, x_size_));
+  std::copy(first - 1, first + words + 1, cells_.row(-1) - 1);
+  std::copy(last - 1, last + words + 1, cells_.row(x_size_) - 1);
 }
 
-void FullyOptimizedGameBoard::set_cell_state(int x, int y, bool state) {
-  if (state) {
-    cells_.set(x, y);
-  } else {
-    cells_.clear(x, y);
+void BitMapGameBoard::clear_ghost_cells() {
+  const int words = cells_.words_per_row();
+  const uint64_t last_word_mask =
+      y_size_ % 64 == 0 ? ~0UL : (1UL << (y_size_ % 64)) - 1;
+  for (int i = 0; i < x_size_; i++) {
+    uint64_t* row = cells_.row(i);
+    row[-1] = 0;
+    row[words - 1] &= last_word_mask;
+    row[words] = 0;
   }
+  std::fill(cells_.row(-1) - 1, cells_.row(-1) + words + 1, 0);
+  std::fill(cells_.row(x_size_) - 1, cells_.row(x_size_) + words + 1, 0);
 }
 
-void FullyOptimizedGameBoard::read_state_from(std::vector<bool>& vec) {
-  assert(vec.size() == (uint64_t)(x_size_ * y_size_));
-  int idx = 0;
+bool BitMapGameBoard::calculate_next_state(int x, int y) {
+  return rule_.next_state(cells_.get(x, y), count_live_neighbors(x, y));
+}
+
+int BitMapGameBoard::report_mem_usage() {
+  return cells_.report_memory_usage() + next_cells_.report_memory_usage();
+}
+
+// ---------------------------------------------------------------------------
+//                   OptimizedGameBoard
+// ---------------------------------------------------------------------------
+
+OptimizedGameBoard::OptimizedGameBoard(int x_size, int y_size,
+                                       const Rule& rule)
+    : BitMapGameBoard(x_size, y_size, rule) {}
+
+void OptimizedGameBoard::update() {
   for (int i = 0; i < x_size_; i++) {
     for (int j = 0; j < y_size_; j++) {
-      if (vec[idx++]) {
-        cells_.set(i, j);
+      if (calculate_next_state(i, j)) {
+        next_cells_.set(i, j);
+      } else {
+        next_cells_.clear(i, j);
       }
     }
   }
+  swap_buffers();
 }
 
+// ---------------------------------------------------------------------------
+//                             Fully Optimized GameBoard
+// ---------------------------------------------------------------------------
+
+FullyOptimizedGameBoard::FullyOptimizedGameBoard(int x_size, int y_size,
+                                                 int num_threads,
+                                                 const Rule& rule)
+    : FullyOptimizedGameBoard(x_size, y_size,
+                              std::make_shared<ThreadPool>(num_threads),
+                              rule) {}
+
+FullyOptimizedGameBoard::FullyOptimizedGameBoard(
+    int x_size, int y_size, std::shared_ptr<ThreadPool> pool, const Rule& rule)
+    : BitMapGameBoard(x_size, y_size, rule), pool_(std::move(pool)) {}
+
 void FullyOptimizedGameBoard::update() {
-  TwoDimBitMap next_cells(x_size_, y_size_);
+  const int nthr = pool_->size();
+  int64_t own_ns = 0;  // Time the calling thread spent on its own rows
   auto update_thread = [&](int tid) {
-    int start = tid * x_size_ / NTHR;
-    int end = (tid + 1) * x_size_ / NTHR;
+    int64_t start_ns = profile_clock_ns();
+    int start = tid * x_size_ / nthr;
+    int end = (tid + 1) * x_size_ / nthr;
     for (int i = start; i < end; i++) {
       for (int j = 0; j < y_size_; j++) {
         if (calculate_next_state(i, j)) {
-          next_cells.set(i, j);
+          next_cells_.set(i, j);
         } else {
-          next_cells.clear(i, j);
+          next_cells_.clear(i, j);
         }
       }
     }
+    if (tid == 0) {
+      own_ns = profile_clock_ns() - start_ns;
+    }
   };
-  // Lauch NTHR threads to update the board
-  std::vector<std::thread> threads;
-  for (int i = 0; i < NTHR; i++) {
-    threads.push_back(std::thread(update_thread, i));
-  }
-  for (auto& t : threads) {
-    t.join();
+  // Hand the rows to the pool, returns once every thread is done. Whatever
+  // the calling thread did not spend on its rows, it waited for the others.
+  int64_t start_ns = profile_clock_ns();
+  pool_->run(update_thread);
+  profile_.sync_ns = profile_clock_ns() - start_ns - own_ns;
+  swap_buffers();
+}
+
+// ---------------------------------------------------------------------------
+//                             BitSliced GameBoard
+// ---------------------------------------------------------------------------
+
+template <typename Boundary>
+BasicBitSlicedGameBoard<Boundary>::BasicBitSlicedGameBoard(int x_size,
+                                                           int y_size,
+                                                           const Rule& rule)
+    : BitMapGameBoard(x_size, y_size, rule) {}
+
+template <typename Boundary>
+void BasicBitSlicedGameBoard<Boundary>::update() {
+  const int words = cells_.words_per_row();
+  // The bits past y_size_ in the last word must stay dead, otherwise they
+  // would be counted as neighbours in the next round
+  const uint64_t last_word_mask =
+      y_size_ % 64 == 0 ? ~0UL : (1UL << (y_size_ % 64)) - 1;
+
+  // With the ghost rows and words filled, the neighbours of the edge cells
+  // need no special casing
+  int64_t start_ns = profile_clock_ns();
+  fill_ghost_cells<Boundary>();
+  int64_t ghost_ns = profile_clock_ns() - start_ns;
+  dispatch_rule(rule_, [&](const auto& rule) {
+    for (int i = 0; i < x_size_; i++) {
+      const uint64_t* up = cells_.row(i - 1);
+      const uint64_t* mid = cells_.row(i);
+      const uint64_t* down = cells_.row(i + 1);
+      uint64_t* out = next_cells_.row(i);
+      for (int k = 0; k < words; k++) {
+        rule_kernel(out[k], rule, up[k - 1], up[k], up[k + 1], mid[k - 1],
+                    mid[k], mid[k + 1], down[k - 1], down[k], down[k + 1]);
+      }
+      out[words - 1] &= last_word_mask;
+    }
+  });
+  start_ns = profile_clock_ns();
+  if (!Boundary::kDead) {
+    clear_ghost_cells();
   }
-  cells_ = next_cells;
+  ghost_ns += profile_clock_ns() - start_ns;
+  swap_buffers();
+  // The ghost cells are bookkeeping between generations, like the swap
+  profile_.swap_ns += ghost_ns;
 }
 
-void FullyOptimizedGameBoard::clear() { cells_.clear(); }
+template class BasicBitSlicedGameBoard<DeadBoundary>;
+template class BasicBitSlicedGameBoard<TorusBoundary>;
+template class BasicBitSlicedGameBoard<MirrorBoundary>;
 
-int FullyOptimizedGameBoard::count_live_neighbors(int x, int y) {
-  int count = 0;
-  for (int i = -1; i <= 1; i++) {
-    for (int j = -1; j <= 1; j++) {
-      if (i == 0 && j == 0) {
-        continue;
+// ---------------------------------------------------------------------------
+//                             LUT GameBoard
+// ---------------------------------------------------------------------------
+
+LutGameBoard::LutGameBoard(int x_size, int y_size, const Rule& rule)
+    : BitMapGameBoard(x_size, y_size, rule), table_(1 << 16) {
+  for (int index = 0; index < (1 << 16); index++) {
+    auto cell = [index](int r, int c) { return (index >> (4 * r + c)) & 1; };
+    for (int r = 1; r <= 2; r++) {
+      for (int c = 1; c <= 2; c++) {
+        int live_neighbors = -cell(r, c);
+        for (int i = -1; i <= 1; i++) {
+          for (int j = -1; j <= 1; j++) {
+            live_neighbors += cell(r + i, c + j);
+          }
+        }
+        if (rule_.next_state(cell(r, c), live_neighbors)) {
+          table_[index] |= 1 << (2 * (r - 1) + (c - 1));
+        }
+      }
+    }
+  }
+}
+
+void LutGameBoard::update() {
+  const uint8_t* table = table_.data();
+  const int words = cells_.words_per_row();
+  const uint64_t last_word_mask =
+      y_size_ % 64 == 0 ? ~0UL : (1UL << (y_size_ % 64)) - 1;
+  // Stands in for the row below the ghost row when x_size_ is odd
+  const std::vector<uint64_t> dead_row(words + 2, 0);
+
+  for (int i = 0; i < x_size_; i += 2) {
+    // The 4 rows around the block rows i and i + 1
+    const uint64_t* rows[4] = {
+        cells_.row(i - 1), cells_.row(i), cells_.row(i + 1),
+        i + 2 <= x_size_ ? cells_.row(i + 2) : dead_row.data() + 1};
+    uint64_t* out0 = next_cells_.row(i);
+    uint64_t* out1 = i + 1 < x_size_ ? next_cells_.row(i + 1) : nullptr;
+    for (int k = 0; k < words; k++) {
+      // Bit b of shifted[r] is cell b - 1 of the word, so the 4 cells around
+      // the block at column j start at bit j. The last block also needs the
+      // last cell of the word and the first cell of the next word.
+      uint64_t shifted[4], tail[4];
+      for (int r = 0; r < 4; r++) {
+        shift_from_prev(shifted[r], rows[r][k], rows[r][k - 1]);
+        tail[r] = shifted[r] >> 62 | (rows[r][k] >> 63) << 2 |
+                  (rows[r][k + 1] & 1) << 3;
       }
-      int new_x = x + i;
-      int new_y = y + j;
-      if (new_x < 0 || new_x >= x_size_ || new_y < 0 || new_y >= y_size_) {
-        continue;
+      uint64_t next0 = 0, next1 = 0;
+      for (int j = 0; j < 64; j += 2) {
+        int index = 0;
+        for (int r = 0; r < 4; r++) {
+          uint64_t nibble = j < 62 ? shifted[r] >> j : tail[r];
+          index |= (nibble & 15) << (4 * r);
+        }
+        const uint64_t next = table[index];
+        next0 |= (next & 3) << j;
+        next1 |= (next >> 2) << j;
       }
-      if (cells_.get(new_x, new_y)) {
-        count++;
+      out0[k] = next0;
+      if (out1) {
+        out1[k] = next1;
       }
     }
+    out0[words - 1] &= last_word_mask;
+    if (out1) {
+      out1[words - 1] &= last_word_mask;
+    }
   }
-  return count;
+  swap_buffers();
 }
 
-bool FullyOptimizedGameBoard::calculate_next_state(int x, int y) {
-  int live_neighbors = count_live_neighbors(x, y);
-  if (cells_.get(x, y)) {
-    return live_neighbors == 2 || live_neighbors == 3;
+// ---------------------------------------------------------------------------
+//                             SIMD GameBoard
+// ---------------------------------------------------------------------------
+
+SimdGameBoard::SimdGameBoard(int x_size, int y_size, SimdIsa isa,
+                             const Rule& rule)
+    : BitMapGameBoard(x_size, y_size, rule),
+      isa_(isa),
+      row_kernel_(get_row_kernel(isa, rule)) {}
+
+void SimdGameBoard::update() {
+  const int words = cells_.words_per_row();
+  const uint64_t last_word_mask =
+      y_size_ % 64 == 0 ? ~0UL : (1UL << (y_size_ % 64)) - 1;
+
+  for (int i = 0; i < x_size_; i++) {
+    uint64_t* out = next_cells_.row(i);
+    row_kernel_(out, cells_.row(i - 1), cells_.row(i), cells_.row(i + 1),
+                words, rule_);
+    out[words - 1] &= last_word_mask;
+  }
+  swap_buffers();
+}
+
+// ---------------------------------------------------------------------------
+//                             Tiled GameBoard
+// ---------------------------------------------------------------------------
+
+TiledGameBoard::TiledGameBoard(int x_size, int y_size, const Rule& rule)
+    : BitMapGameBoard(x_size, y_size, rule),
+      tiles_x_((x_size - 1) / 64 + 1),
+      tiles_y_(cells_.words_per_row()),
+      changed_((tiles_x_ + 2) * (tiles_y_ + 2), 0),
+      next_changed_((tiles_x_ + 2) * (tiles_y_ + 2), 0),
+      active_tiles_(0),
+      skipped_tiles_(0),
+      last_active_tiles_(0),
+      tile_population_((tiles_x_ + 2) * (tiles_y_ + 2), 0),
+      stale_tiles_((tiles_x_ + 2) * (tiles_y_ + 2), 0),
+      tiled_population_(0) {
+  mark_all_changed();
+}
+
+void TiledGameBoard::mark_all_changed() {
+  for (int tx = 0; tx < tiles_x_; tx++) {
+    for (int ty = 0; ty < tiles_y_; ty++) {
+      changed_[tile_index(tx, ty)] = 1;
+      stale_tiles_[tile_index(tx, ty)] = 1;
+    }
+  }
+}
+
+void TiledGameBoard::set_cell_state(int x, int y, bool state) {
+  BitMapGameBoard::set_cell_state(x, y, state);
+  changed_[tile_index(x / 64, y / 64)] = 1;
+  stale_tiles_[tile_index(x / 64, y / 64)] = 1;
+}
+
+void TiledGameBoard::read_state_from(std::vector<bool>& vec) {
+  BitMapGameBoard::read_state_from(vec);
+  mark_all_changed();
+}
+
+void TiledGameBoard::set_word(int x, int k, uint64_t word) {
+  BitMapGameBoard::set_word(x, k, word);
+  changed_[tile_index(x / 64, k)] = 1;
+  stale_tiles_[tile_index(x / 64, k)] = 1;
+}
+
+void TiledGameBoard::import_bytes(const uint8_t* bytes, size_t size) {
+  BitMapGameBoard::import_bytes(bytes, size);
+  mark_all_changed();
+}
+
+void TiledGameBoard::adopt_cells(TwoDimBitMap&& cells) {
+  BitMapGameBoard::adopt_cells(std::move(cells));
+  mark_all_changed();
+}
+
+void TiledGameBoard::clear() {
+  BitMapGameBoard::clear();
+  mark_all_changed();
+}
+
+// A tile whose 3x3 neighbourhood did not change in the last generation has
+// the same state as one generation ago. The back buffer still holds that
+// generation, so a skipped tile is already correct in the back buffer.
+void TiledGameBoard::update() {
+  const int words = cells_.words_per_row();
+  const uint64_t last_word_mask =
+      y_size_ % 64 == 0 ? ~0UL : (1UL << (y_size_ % 64)) - 1;
+
+  const uint64_t active_before = active_tiles_;
+  dispatch_rule(rule_, [&](const auto& rule) {
+    for (int tx = 0; tx < tiles_x_; tx++) {
+      for (int ty = 0; ty < tiles_y_; ty++) {
+        bool active = false;
+        for (int i = -1; i <= 1; i++) {
+          for (int j = -1; j <= 1; j++) {
+            active |= changed_[tile_index(tx + i, ty + j)];
+          }
+        }
+        if (!active) {
+          next_changed_[tile_index(tx, ty)] = 0;
+          skipped_tiles_++;
+          continue;
+        }
+        active_tiles_++;
+
+        const int k = ty;
+        const uint64_t mask = k == words - 1 ? last_word_mask : ~0UL;
+        const int row_end = std::min(x_size_, (tx + 1) * 64);
+        uint64_t diff = 0;
+        for (int i = tx * 64; i < row_end; i++) {
+          const uint64_t* up = cells_.row(i - 1);
+          const uint64_t* mid = cells_.row(i);
+          const uint64_t* down = cells_.row(i + 1);
+          uint64_t& out = next_cells_.row(i)[k];
+          rule_kernel(out, rule, up[k - 1], up[k], up[k + 1], mid[k - 1],
+                      mid[k], mid[k + 1], down[k - 1], down[k], down[k + 1]);
+          out &= mask;
+          diff |= out ^ mid[k];
+        }
+        next_changed_[tile_index(tx, ty)] = diff != 0;
+        stale_tiles_[tile_index(tx, ty)] |= diff != 0;
+      }
+    }
+  });
+  last_active_tiles_ = active_tiles_ - active_before;
+  swap_buffers();
+  std::swap(changed_, next_changed_);
+}
+
+uint64_t TiledGameBoard::population() const {
+  std::vector<uint32_t> counts(tiles_y_);
+  for (int tx = 0; tx < tiles_x_; tx++) {
+    bool stale = false;
+    for (int ty = 0; ty < tiles_y_; ty++) {
+      stale |= stale_tiles_[tile_index(tx, ty)];
+    }
+    if (!stale) {
+      continue;
+    }
+    // Count the whole row of tiles, row by row, rather than the stale tiles
+    // one word per row at a time
+    std::fill(counts.begin(), counts.end(), 0);
+    for (int i = tx * 64; i < std::min(x_size_, (tx + 1) * 64); i++) {
+      popcount_add(cells_.row(i), tiles_y_, counts.data());
+    }
+    for (int ty = 0; ty < tiles_y_; ty++) {
+      const int index = tile_index(tx, ty);
+      if (stale_tiles_[index]) {
+        tiled_population_ =
+            tiled_population_ + counts[ty] - tile_population_[index];
+        tile_population_[index] = counts[ty];
+        stale_tiles_[index] = 0;
+      }
+    }
   }
-  return live_neighbors == 3;
+  return tiled_population_;
 }
 
-int FullyOptimizedGameBoard::report_mem_usage() {
-  return cells_.report_memory_usage();
+int TiledGameBoard::report_mem_usage() {
+  return BitMapGameBoard::report_mem_usage() +
+         (changed_.size() + next_changed_.size() + stale_tiles_.size()) *
+             sizeof(uint8_t) +
+         tile_population_.size() * sizeof(uint32_t);
 }
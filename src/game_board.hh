@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <climits>
 #include <iostream>
 #include <memory>
 #include <sstream>  // For stringstream
@@ -8,8 +10,31 @@
 #include <vector>
 
 #include "bit_map.hh"
+#include "boundary.hh"
+#include "metrics.hh"
+#include "rule.hh"
+#include "simd_kernel.hh"
+#include "thread_pool.hh"
 
-#define NTHR 8
+// The smallest rectangle holding all live cells, bounds included
+struct BoundingBox {
+  int x_min = INT_MAX, y_min = INT_MAX;
+  int x_max = INT_MIN, y_max = INT_MIN;
+
+  // Whether there are no live cells at all
+  bool empty() const { return x_min > x_max; }
+  // Grow the box to hold (x, y)
+  void add(int x, int y) {
+    x_min = std::min(x_min, x);
+    x_max = std::max(x_max, x);
+    y_min = std::min(y_min, y);
+    y_max = std::max(y_max, y);
+  }
+  bool operator==(const BoundingBox& other) const {
+    return x_min == other.x_min && y_min == other.y_min &&
+           x_max == other.x_max && y_max == other.y_max;
+  }
+};
 
 class AbstractGameBoard {
  public:
@@ -20,14 +45,53 @@ class AbstractGameBoard {
   virtual void read_state_from(std::vector<bool>& vec) = 0;
   virtual void update() = 0;  // Update the board state to the next generation
   virtual void clear() = 0;   // Clear the board
+  // Advance the board by `generations` generations. Engines that can skip
+  // ahead override this, by default it simply calls update() repeatedly.
+  virtual void advance(uint64_t generations) {
+    for (uint64_t i = 0; i < generations; i++) update();
+  }
+  // The rule the board evolves under
+  virtual const Rule& get_rule() const = 0;
   // For test purpose
   virtual int report_mem_usage() = 0;
+  // Number of live cells. By default every cell is visited; engines that
+  // can count faster override this.
+  virtual uint64_t population() const;
+  // Number of cells the last update() computed, the whole board by default.
+  // Engines that skip inactive regions report what they did not skip.
+  virtual uint64_t active_cells() const;
+  // The live cells, by default found by visiting every cell
+  virtual BoundingBox bounding_box() const;
+  // Where the last update() spent its time, see Metrics
+  const UpdateProfile& last_update_profile() const { return profile_; }
+
+  // Bulk state I/O in the packed layout: every row x is packed_row_words()
+  // words, cell (x, y) is bit y % 64 of word y / 64 of the row and the bits
+  // past the last cell are zero. A board is x_size * packed_row_words()
+  // words, or 8 times as many bytes in little-endian order. The defaults go
+  // through the cells one by one; boards storing packed words copy them.
+  int packed_row_words() const { return (get_board_size().second + 63) / 64; }
+  // Word k of row x
+  virtual uint64_t get_word(int x, int k) const;
+  // Set word k of row x, the bits past the last cell are ignored
+  virtual void set_word(int x, int k, uint64_t word);
+  // Replace the cells of the board with / copy them to `size` bytes, throws
+  // std::invalid_argument unless `size` is the size of the board
+  virtual void import_bytes(const uint8_t* bytes, size_t size);
+  virtual void export_bytes(uint8_t* bytes, size_t size) const;
+  void import_words(const std::vector<uint64_t>& words);
+  std::vector<uint64_t> export_words() const;
+
+  // Boards are equal if they have the same size and cells. Boards storing
+  // packed words are compared a row at a time.
   bool operator==(const AbstractGameBoard& other) const;
   bool operator!=(const AbstractGameBoard& other) const {
     return !(*this == other);
   }
 
  protected:
+  UpdateProfile profile_;  // Filled by update() of the engines that profile
+
   // Count the number of live neighbors for a given cell
   virtual int count_live_neighbors(int x, int y) = 0;
   // Calculate the next state of a cell at a given position
@@ -35,11 +99,16 @@ class AbstractGameBoard {
 };
 
 // Unoptimized implementation of the game board
-class GameBoard : public AbstractGameBoard {
+// The cells are stored with a ring of ghost cells around the board, which is
+// filled once per generation according to the `Boundary` policy (see
+// boundary.hh), so counting the neighbours needs no bounds checks.
+template <typename Boundary>
+class BasicGameBoard : public AbstractGameBoard {
  public:
-  GameBoard(int x_size, int y_size);
-  ~GameBoard() = default;
+  BasicGameBoard(int x_size, int y_size, const Rule& rule = Rule());
+  ~BasicGameBoard() = default;
   std::pair<int, int> get_board_size() const;
+  const Rule& get_rule() const { return rule_; }
   bool get_cell_state(int x, int y) const;
   void set_cell_state(int x, int y, bool state);
   void read_state_from(std::vector<bool>& vec);
@@ -54,55 +123,235 @@ class GameBoard : public AbstractGameBoard {
   bool calculate_next_state(int x, int y);
 
  private:
-  int x_size_, y_size_;                   // The size of the board
-  std::vector<std::vector<bool>> cells_;  // The cells of the board
+  // Copy the edge cells into the ghost ring of the current generation
+  void fill_ghost_cells();
+
+  int x_size_, y_size_;  // The size of the board
+  Rule rule_;
+  // Both generations of the cells in one allocation, each padded to
+  // (x_size_ + 2) x (y_size_ + 2): the current one starts at `front_`, the
+  // next one is written to the other half
+  std::vector<bool> cells_;
+  int front_;
+
+  // Index of cell (x, y) of the current generation, x and y may be -1 or
+  // one past the last cell to address the ghost ring
+  int index(int x, int y) const {
+    return front_ + (x + 1) * (y_size_ + 2) + y + 1;
+  }
+  bool cell(int x, int y) const { return cells_[index(x, y)]; }
 };
 
-// Optimized implementation of the game board
-// Use bit_map to represent the cell states
-class OptimizedGameBoard : public AbstractGameBoard {
+typedef BasicGameBoard<DeadBoundary> GameBoard;
+
+// Common base of the boards storing their cells in a TwoDimBitMap
+// The board keeps two preallocated buffers: the current generation is read
+// from `cells_` while update() writes the next one to `next_cells_`, then the
+// two are swapped. No memory is allocated or copied per generation.
+class BitMapGameBoard : public AbstractGameBoard {
  public:
-  OptimizedGameBoard(int x_size, int y_size);
+  BitMapGameBoard(int x_size, int y_size, const Rule& rule);
   std::pair<int, int> get_board_size() const;
+  const Rule& get_rule() const { return rule_; }
   bool get_cell_state(int x, int y) const;
   void set_cell_state(int x, int y, bool state);
   void read_state_from(std::vector<bool>& vec);
 
-  void update();
   void clear();
 
   int report_mem_usage();
 
+  // Counted with POPCNT over the words of the board, at most once per
+  // generation: the count is kept until update() or a write changes it
+  uint64_t population() const;
+  BoundingBox bounding_box() const;
+  // Live cells of every row
+  std::vector<uint32_t> row_population() const;
+  // Live cells of every tile of 64 x 64 cells, i.e. 64 rows of one word.
+  // Tile (tx, ty) holds the rows [64 tx, 64 tx + 64) of word ty and is at
+  // tx * words_per_row + ty.
+  std::vector<uint32_t> tile_population() const;
+
+  uint64_t get_word(int x, int k) const { return cells_.row(x)[k]; }
+  void set_word(int x, int k, uint64_t word);
+  void import_bytes(const uint8_t* bytes, size_t size);
+  void export_bytes(uint8_t* bytes, size_t size) const;
+  // Whether both boards have the same cells, compared row by row
+  bool same_cells(const BitMapGameBoard& other) const;
+
+  // The current generation, e.g. to write it out as it is
+  const TwoDimBitMap& cells() const { return cells_; }
+  // Make `cells` the current generation without copying them, e.g. a
+  // snapshot mapped into memory. Throws std::invalid_argument unless they
+  // have the size of the board.
+  virtual void adopt_cells(TwoDimBitMap&& cells);
+
  protected:
   int count_live_neighbors(int x, int y);
   bool calculate_next_state(int x, int y);
 
- private:
-  int x_size_, y_size_;  // The size of the board
-  TwoDimBitMap cells_;   // The cells of the board
+  // The bits of word k of a row that hold cells
+  uint64_t word_mask(int k) const {
+    return k == cells_.words_per_row() - 1 && y_size_ % 64
+               ? (1UL << (y_size_ % 64)) - 1
+               : ~0UL;
+  }
+
+  // Make the back buffer the current generation
+  void swap_buffers() {
+    int64_t start = profile_clock_ns();
+    std::swap(cells_, next_cells_);
+    population_valid_ = false;
+    profile_.swap_ns = profile_clock_ns() - start;
+  }
+
+  // Fill the ghost rows and words of `cells_`, and the bit right after the
+  // last cell of every row, according to the `Boundary` policy.
+  // clear_ghost_cells() makes them dead again, as the rest of the board
+  // expects.
+  template <typename Boundary>
+  void fill_ghost_cells();
+  void clear_ghost_cells();
+
+  int x_size_, y_size_;      // The size of the board
+  Rule rule_;                // The rule of the game
+  TwoDimBitMap cells_;       // The current generation
+  TwoDimBitMap next_cells_;  // The next generation, written by update()
+
+  mutable uint64_t population_;     // Live cells, if `population_valid_`
+  mutable bool population_valid_;
+};
+
+// Optimized implementation of the game board
+// Use bit_map to represent the cell states
+class OptimizedGameBoard : public BitMapGameBoard {
+ public:
+  OptimizedGameBoard(int x_size, int y_size, const Rule& rule = Rule());
+
+  void update();
 };
 
 // Fully optimized implementation of the game board
 // Beside using bit_map to compress the memory usage, we also use
-// multi-threading to speed up the calculation
-class FullyOptimizedGameBoard : public AbstractGameBoard {
+// multi-threading to speed up the calculation. The worker threads live in a
+// persistent pool which is either owned by the board or shared with others.
+class FullyOptimizedGameBoard : public BitMapGameBoard {
  public:
-  FullyOptimizedGameBoard(int x_size, int y_size);
-  std::pair<int, int> get_board_size() const;
-  bool get_cell_state(int x, int y) const;
+  // `num_threads` of 0 means one thread per hardware thread
+  FullyOptimizedGameBoard(int x_size, int y_size, int num_threads = 0,
+                          const Rule& rule = Rule());
+  FullyOptimizedGameBoard(int x_size, int y_size,
+                          std::shared_ptr<ThreadPool> pool,
+                          const Rule& rule = Rule());
+
+  void update();
+
+ private:
+  std::shared_ptr<ThreadPool> pool_;  // The threads computing update()
+};
+
+// Bit-sliced implementation of the game board
+// Instead of visiting the cells one by one, the next state of a whole word
+// (64 cells) is computed at once with a bitwise adder network over the rows
+// above, the current row and the row below. The ghost rows and words of the
+// bit map are filled according to the `Boundary` policy before the kernel
+// runs, so the edges are handled without any branches in the kernel.
+template <typename Boundary>
+class BasicBitSlicedGameBoard : public BitMapGameBoard {
+ public:
+  BasicBitSlicedGameBoard(int x_size, int y_size, const Rule& rule = Rule());
+
+  void update();
+};
+
+typedef BasicBitSlicedGameBoard<DeadBoundary> BitSlicedGameBoard;
+
+// Lookup-table implementation of the game board
+// The board is updated in blocks of 2x2 cells. The 4x4 neighbourhood of a
+// block is packed into a 16-bit index into a 65536-entry table, built for
+// the rule of the board when it is created, which holds the next state of
+// the 2x2 block. The table is 64 KiB, so it stays in cache, and needs no
+// SIMD support.
+class LutGameBoard : public BitMapGameBoard {
+ public:
+  LutGameBoard(int x_size, int y_size, const Rule& rule = Rule());
+
+  void update();
+
+ private:
+  // The table, indexed by the 4x4 cells with bit 4 * r + c holding row r and
+  // column c. Entry bit 2 * r + c holds the next state of cell (r + 1, c + 1).
+  std::vector<uint8_t> table_;
+};
+
+// SIMD implementation of the game board
+// Uses the same bit-sliced kernel as BitSlicedGameBoard, but evaluates it on
+// 256-bit (AVX2) or 512-bit (AVX-512) vectors. The instruction set is picked
+// at runtime and falls back to the portable scalar kernel.
+class SimdGameBoard : public BitMapGameBoard {
+ public:
+  SimdGameBoard(int x_size, int y_size, SimdIsa isa = best_simd_isa(),
+                const Rule& rule = Rule());
+
+  void update();
+
+  // The instruction set the board runs on
+  SimdIsa get_isa() const { return isa_; }
+
+ private:
+  SimdIsa isa_;  // The instruction set of row_kernel_
+  RowKernel row_kernel_;
+};
+
+// Tiled implementation of the game board
+// The board is split into tiles of 64x64 cells (64 rows of one word each).
+// Each tile remembers whether it changed in the last generation; a tile is
+// only recomputed if it or one of its eight neighbours changed, otherwise
+// its next state is its current state. Dead and still-life regions are
+// therefore skipped entirely.
+class TiledGameBoard : public BitMapGameBoard {
+ public:
+  TiledGameBoard(int x_size, int y_size, const Rule& rule = Rule());
   void set_cell_state(int x, int y, bool state);
   void read_state_from(std::vector<bool>& vec);
+  void set_word(int x, int k, uint64_t word);
+  void import_bytes(const uint8_t* bytes, size_t size);
+  void adopt_cells(TwoDimBitMap&& cells);
 
   void update();
   void clear();
 
   int report_mem_usage();
 
- protected:
-  int count_live_neighbors(int x, int y);
-  bool calculate_next_state(int x, int y);
+  // Number of tiles recomputed / skipped, accumulated over all generations
+  uint64_t report_active_tiles() const { return active_tiles_; }
+  uint64_t report_skipped_tiles() const { return skipped_tiles_; }
+  // The cells of the tiles recomputed in the last generation
+  uint64_t active_cells() const { return last_active_tiles_ * 64 * 64; }
+  // Only the tiles that changed since the last call are counted again, so
+  // stable regions cost nothing
+  uint64_t population() const;
 
  private:
-  int x_size_, y_size_;  // The size of the board
-  TwoDimBitMap cells_;   // The cells of the board
+  // Index of the flag of tile (tx, ty). The flag grids have a ring of
+  // always-clear flags around them, so tx and ty may be -1 or one past the
+  // last tile.
+  int tile_index(int tx, int ty) const {
+    return (tx + 1) * (tiles_y_ + 2) + ty + 1;
+  }
+  // Force every tile to be recomputed in the next generation
+  void mark_all_changed();
+
+  int tiles_x_, tiles_y_;              // Number of tiles along each axis
+  std::vector<uint8_t> changed_;       // Tiles changed in the last generation
+  std::vector<uint8_t> next_changed_;  // Tiles changed by the current update
+  uint64_t active_tiles_;
+  uint64_t skipped_tiles_;
+  uint64_t last_active_tiles_;  // Tiles recomputed in the last generation
+
+  // Live cells per tile, indexed like `changed_`. A tile is stale if it
+  // changed since it was last counted.
+  mutable std::vector<uint32_t> tile_population_;
+  mutable std::vector<uint8_t> stale_tiles_;
+  mutable uint64_t tiled_population_;  // Sum of `tile_population_`
 };
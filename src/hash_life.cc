@@ -0,0 +1,455 @@
+#include "hash_life.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace {
+
+// Largest jump advance() makes at once. Bounds the level of the root, so the
+// coordinates of the expanded universe fit in 64 bits.
+constexpr int kMaxStep = 56;
+// Longest period advance() looks for on boards that keep touching the edge
+constexpr size_t kMaxPeriod = 64;
+
+}  // namespace
+
+size_t HashLifeGameBoard::NodeHash::operator()(const Node& node) const {
+  uint64_t h = reinterpret_cast<uintptr_t>(node.nw);
+  h = h * 0x9E3779B97F4A7C15UL + reinterpret_cast<uintptr_t>(node.ne);
+  h = h * 0x9E3779B97F4A7C15UL + reinterpret_cast<uintptr_t>(node.sw);
+  h = h * 0x9E3779B97F4A7C15UL + reinterpret_cast<uintptr_t>(node.se);
+  return h ^ (h >> 32);
+}
+
+bool HashLifeGameBoard::NodeEqual::operator()(const Node& a,
+                                              const Node& b) const {
+  return a.nw == b.nw && a.ne == b.ne && a.sw == b.sw && a.se == b.se;
+}
+
+HashLifeGameBoard::HashLifeGameBoard(int x_size, int y_size, size_t max_nodes,
+                                     const Rule& rule)
+    : x_size_(x_size),
+      y_size_(y_size),
+      max_nodes_(max_nodes),
+      rule_(rule),
+      dead_leaf_{nullptr, nullptr, nullptr, nullptr, 0, 0},
+      alive_leaf_{nullptr, nullptr, nullptr, nullptr, 0, 1},
+      base_level_(3),
+      step_(0) {
+  if (rule.births_from_nothing()) {
+    throw std::invalid_argument("HashLife does not support " +
+                                rule.to_string() + ", it has B0");
+  }
+  while ((1 << base_level_) < std::max(x_size, y_size)) {
+    base_level_++;
+  }
+  empties_.push_back(&dead_leaf_);
+  root_ = empty(base_level_);
+}
+
+std::pair<int, int> HashLifeGameBoard::get_board_size() const {
+  return std::make_pair(x_size_, y_size_);
+}
+
+// ---------------------------------------------------------------------------
+//                             Node construction
+// ---------------------------------------------------------------------------
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::join(const Node* nw,
+                                                       const Node* ne,
+                                                       const Node* sw,
+                                                       const Node* se) {
+  Node node{nw,
+            ne,
+            sw,
+            se,
+            nw->level + 1,
+            nw->population + ne->population + sw->population +
+                se->population};
+  return &*nodes_.insert(node).first;
+}
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::empty(int level) {
+  while (static_cast<int>(empties_.size()) <= level) {
+    const Node* e = empties_.back();
+    empties_.push_back(join(e, e, e, e));
+  }
+  return empties_[level];
+}
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::center(const Node* node) {
+  return join(node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+}
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::horizontal_center(
+    const Node* w, const Node* e) {
+  return join(w->ne, e->nw, w->se, e->sw);
+}
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::vertical_center(
+    const Node* n, const Node* s) {
+  return join(n->sw, n->se, s->nw, s->ne);
+}
+
+void HashLifeGameBoard::expand() {
+  const Node* e = empty(root_->level - 1);
+  root_ = join(join(e, e, e, root_->nw), join(e, e, root_->ne, e),
+               join(e, root_->sw, e, e), join(root_->se, e, e, e));
+}
+
+// ---------------------------------------------------------------------------
+//                             Evolution
+// ---------------------------------------------------------------------------
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::base_successor(
+    const Node* node) {
+  bool cells[4][4];
+  for (int x = 0; x < 4; x++) {
+    for (int y = 0; y < 4; y++) {
+      cells[x][y] = get_cell(node, x, y);
+    }
+  }
+  const Node* next[2][2];
+  for (int x = 1; x <= 2; x++) {
+    for (int y = 1; y <= 2; y++) {
+      int live_neighbors = 0;
+      for (int i = -1; i <= 1; i++) {
+        for (int j = -1; j <= 1; j++) {
+          if ((i != 0 || j != 0) && cells[x + i][y + j]) {
+            live_neighbors++;
+          }
+        }
+      }
+      bool alive = rule_.next_state(cells[x][y], live_neighbors);
+      next[x - 1][y - 1] = alive ? &alive_leaf_ : &dead_leaf_;
+    }
+  }
+  return join(next[0][0], next[1][0], next[0][1], next[1][1]);
+}
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::successor(const Node* node) {
+  if (node->population == 0) {
+    return empty(node->level - 1);
+  }
+  // A level k node can advance at most 2^(k-2) generations
+  const int step = std::min(step_, node->level - 2);
+  if (node->result != nullptr && node->result_step == step) {
+    return node->result;
+  }
+
+  const Node* result;
+  if (node->level == 2) {
+    result = base_successor(node);
+  } else {
+    // The nine overlapping subnodes of half the size
+    const Node* n00 = node->nw;
+    const Node* n01 = horizontal_center(node->nw, node->ne);
+    const Node* n02 = node->ne;
+    const Node* n10 = vertical_center(node->nw, node->sw);
+    const Node* n11 = center(node);
+    const Node* n12 = vertical_center(node->ne, node->se);
+    const Node* n20 = node->sw;
+    const Node* n21 = horizontal_center(node->sw, node->se);
+    const Node* n22 = node->se;
+    if (step == node->level - 2) {
+      // Full speed: advance the nine subnodes by half of the step, then the
+      // four quadrants assembled from them by the other half
+      n00 = successor(n00);
+      n01 = successor(n01);
+      n02 = successor(n02);
+      n10 = successor(n10);
+      n11 = successor(n11);
+      n12 = successor(n12);
+      n20 = successor(n20);
+      n21 = successor(n21);
+      n22 = successor(n22);
+    } else {
+      // Smaller step: only the quadrants advance, the subnodes are just
+      // cropped to their centers
+      n00 = center(n00);
+      n01 = center(n01);
+      n02 = center(n02);
+      n10 = center(n10);
+      n11 = center(n11);
+      n12 = center(n12);
+      n20 = center(n20);
+      n21 = center(n21);
+      n22 = center(n22);
+    }
+    result = join(successor(join(n00, n01, n10, n11)),
+                  successor(join(n01, n02, n11, n12)),
+                  successor(join(n10, n11, n20, n21)),
+                  successor(join(n11, n12, n21, n22)));
+  }
+  node->result = result;
+  node->result_step = step;
+  return result;
+}
+
+void HashLifeGameBoard::jump(int step) {
+  if (nodes_.size() > max_nodes_) {
+    collect_garbage();
+  }
+  step_ = step;
+  // The RESULT of the root is its center, which must still cover the board,
+  // and it can advance at most 2^(level-2) generations. Every expansion keeps
+  // the board centered, so the top left cell of a root of level k is at
+  // -(2^(k-1) - 2^(base_level_-1)).
+  do {
+    expand();
+  } while (root_->level < step + 2);
+  root_ = successor(root_);
+
+  int64_t origin = (int64_t{1} << (base_level_ - 1)) -
+                   (int64_t{1} << (root_->level - 1));
+  root_ = clip(root_, origin, origin);
+  // Everything alive is on the board now, so cropping the centers is
+  // lossless and gets us back to the base level at (0, 0)
+  while (root_->level > base_level_) {
+    root_ = center(root_);
+  }
+}
+
+void HashLifeGameBoard::update() { jump(0); }
+
+void HashLifeGameBoard::advance(uint64_t generations) {
+  recent_roots_.clear();
+  while (generations != 0) {
+    BoundingBox box = bounding_box();
+    if (box.empty()) {
+      break;  // Without B0 an empty board stays empty
+    }
+    // Live cells spread at most one cell per generation, so a jump of no
+    // more generations than there are dead cells between the pattern and
+    // the edge never brings a cell to life off the board, where update()
+    // would have clipped it. Next to the edge that is a single generation.
+    int64_t margin = std::min(
+        {int64_t{box.x_min}, int64_t{box.y_min},
+         int64_t{x_size_} - 1 - box.x_max, int64_t{y_size_} - 1 - box.y_max});
+    int step = 0;
+    while (step < kMaxStep && (uint64_t{2} << step) <= generations &&
+           (int64_t{2} << step) <= margin) {
+      step++;
+    }
+    if (step > 0) {
+      recent_roots_.clear();
+    } else {
+      // Nodes are canonical, so the board repeats exactly when the root
+      // does. Once it does, whole periods can be skipped, which keeps ash
+      // and blocks left on the edge from forcing single generations.
+      auto seen = std::find(recent_roots_.begin(), recent_roots_.end(), root_);
+      if (seen != recent_roots_.end()) {
+        generations %= recent_roots_.end() - seen;
+        recent_roots_.clear();
+        continue;
+      }
+      if (recent_roots_.size() == kMaxPeriod) {
+        recent_roots_.erase(recent_roots_.begin());
+      }
+      recent_roots_.push_back(root_);
+    }
+    jump(step);
+    generations -= uint64_t{1} << step;
+  }
+  recent_roots_.clear();
+}
+
+// ---------------------------------------------------------------------------
+//                             Cell access
+// ---------------------------------------------------------------------------
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::build(
+    const std::vector<bool>& vec, int level, int64_t x, int64_t y) {
+  if (x >= x_size_ || y >= y_size_) {
+    return empty(level);
+  }
+  if (level == 0) {
+    return vec[x * y_size_ + y] ? &alive_leaf_ : &dead_leaf_;
+  }
+  int64_t half = int64_t{1} << (level - 1);
+  return join(build(vec, level - 1, x, y), build(vec, level - 1, x + half, y),
+              build(vec, level - 1, x, y + half),
+              build(vec, level - 1, x + half, y + half));
+}
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::clip(const Node* node,
+                                                       int64_t x, int64_t y) {
+  int64_t size = int64_t{1} << node->level;
+  if (node->population == 0 ||
+      (x >= 0 && y >= 0 && x + size <= x_size_ && y + size <= y_size_)) {
+    return node;
+  }
+  if (x >= x_size_ || y >= y_size_ || x + size <= 0 || y + size <= 0) {
+    return empty(node->level);
+  }
+  int64_t half = size / 2;
+  return join(clip(node->nw, x, y), clip(node->ne, x + half, y),
+              clip(node->sw, x, y + half), clip(node->se, x + half, y + half));
+}
+
+const HashLifeGameBoard::Node* HashLifeGameBoard::set_cell(const Node* node,
+                                                           int64_t x,
+                                                           int64_t y,
+                                                           bool state) {
+  if (node->level == 0) {
+    return state ? &alive_leaf_ : &dead_leaf_;
+  }
+  int64_t half = int64_t{1} << (node->level - 1);
+  const Node* nw = node->nw;
+  const Node* ne = node->ne;
+  const Node* sw = node->sw;
+  const Node* se = node->se;
+  if (x < half && y < half) {
+    nw = set_cell(nw, x, y, state);
+  } else if (y < half) {
+    ne = set_cell(ne, x - half, y, state);
+  } else if (x < half) {
+    sw = set_cell(sw, x, y - half, state);
+  } else {
+    se = set_cell(se, x - half, y - half, state);
+  }
+  return join(nw, ne, sw, se);
+}
+
+bool HashLifeGameBoard::get_cell(const Node* node, int64_t x,
+                                 int64_t y) const {
+  while (node->level > 0) {
+    if (node->population == 0) {
+      return false;
+    }
+    int64_t half = int64_t{1} << (node->level - 1);
+    if (x < half && y < half) {
+      node = node->nw;
+    } else if (y < half) {
+      node = node->ne;
+      x -= half;
+    } else if (x < half) {
+      node = node->sw;
+      y -= half;
+    } else {
+      node = node->se;
+      x -= half;
+      y -= half;
+    }
+  }
+  return node == &alive_leaf_;
+}
+
+bool HashLifeGameBoard::get_cell_state(int x, int y) const {
+  return get_cell(root_, x, y);
+}
+
+void HashLifeGameBoard::set_cell_state(int x, int y, bool state) {
+  assert(x >= 0 && x < x_size_ && y >= 0 && y < y_size_);
+  root_ = set_cell(root_, x, y, state);
+}
+
+void HashLifeGameBoard::add_to_box(const Node* node, int64_t x, int64_t y,
+                                   BoundingBox& box) const {
+  if (node->population == 0) {
+    return;
+  }
+  // A node inside the box found so far cannot grow it
+  int64_t size = int64_t{1} << node->level;
+  if (x >= box.x_min && y >= box.y_min && x + size - 1 <= box.x_max &&
+      y + size - 1 <= box.y_max) {
+    return;
+  }
+  if (node->level == 0) {
+    box.add(static_cast<int>(x), static_cast<int>(y));
+    return;
+  }
+  int64_t half = size / 2;
+  add_to_box(node->nw, x, y, box);
+  add_to_box(node->ne, x + half, y, box);
+  add_to_box(node->sw, x, y + half, box);
+  add_to_box(node->se, x + half, y + half, box);
+}
+
+BoundingBox HashLifeGameBoard::bounding_box() const {
+  BoundingBox box;
+  add_to_box(root_, 0, 0, box);
+  return box;
+}
+
+void HashLifeGameBoard::read_state_from(std::vector<bool>& vec) {
+  assert(vec.size() == (uint64_t)(x_size_ * y_size_));
+  root_ = build(vec, base_level_, 0, 0);
+}
+
+void HashLifeGameBoard::clear() { root_ = empty(base_level_); }
+
+int HashLifeGameBoard::count_live_neighbors(int x, int y) {
+  int count = 0;
+  for (int i = -1; i <= 1; i++) {
+    for (int j = -1; j <= 1; j++) {
+      if (i == 0 && j == 0) {
+        continue;
+      }
+      int new_x = x + i;
+      int new_y = y + j;
+      if (new_x < 0 || new_x >= x_size_ || new_y < 0 || new_y >= y_size_) {
+        continue;
+      }
+      if (get_cell_state(new_x, new_y)) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+bool HashLifeGameBoard::calculate_next_state(int x, int y) {
+  return rule_.next_state(get_cell_state(x, y), count_live_neighbors(x, y));
+}
+
+// ---------------------------------------------------------------------------
+//                             Memory management
+// ---------------------------------------------------------------------------
+
+void HashLifeGameBoard::mark(const Node* node) {
+  if (node->level == 0 || node->marked) {
+    return;
+  }
+  node->marked = true;
+  mark(node->nw);
+  mark(node->ne);
+  mark(node->sw);
+  mark(node->se);
+}
+
+void HashLifeGameBoard::collect_garbage() {
+  for (const Node& node : nodes_) {
+    node.marked = false;
+  }
+  mark(root_);
+  for (const Node* root : recent_roots_) {
+    mark(root);
+  }
+  for (const Node* e : empties_) {
+    mark(e);
+  }
+  // Forget the RESULTs that point to nodes about to be freed
+  for (const Node& node : nodes_) {
+    if (node.result != nullptr && !node.result->marked) {
+      node.result = nullptr;
+      node.result_step = -1;
+    }
+  }
+  for (auto it = nodes_.begin(); it != nodes_.end();) {
+    if (it->marked) {
+      ++it;
+    } else {
+      it = nodes_.erase(it);
+    }
+  }
+}
+
+int HashLifeGameBoard::report_mem_usage() {
+  // Each node lives in its own hash table entry next to the next pointer and
+  // the cached hash; the table itself is an array of bucket pointers
+  size_t entry = sizeof(Node) + sizeof(void*) + sizeof(size_t);
+  size_t total = nodes_.size() * entry + nodes_.bucket_count() * sizeof(void*);
+  return static_cast<int>(std::min<size_t>(total, INT32_MAX));
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "game_board.hh"
+
+// Default number of quadtree nodes kept before garbage collection kicks in
+#define HASHLIFE_MAX_NODES (1 << 22)
+
+/**
+ * HashLife implementation of the game board.
+ *
+ * The board is a quadtree whose nodes are canonicalized (hash-consed), so
+ * identical regions anywhere in space and time share one node. Every node of
+ * level k (2^k x 2^k cells) memoizes its RESULT: its center 2^(k-1) square
+ * advanced up to 2^(k-2) generations. Repetitive patterns are therefore
+ * computed once, and advance() can jump 2^j generations at the cost of a
+ * single RESULT of a large enough node.
+ *
+ * Cells outside the board are dead. update() clips the universe to the board
+ * after every generation, so it matches GameBoard exactly. A jump only clips
+ * at its end, so advance() jumps 2^j generations only while the live cells
+ * are at least 2^j cells away from every edge, and steps one generation at a
+ * time next to the edge until the board repeats. It therefore always matches
+ * the same number of update() calls.
+ *
+ * Coordinates follow the rest of the boards: the board is x_size cells wide
+ * and y_size cells high; nw/ne/sw/se are the quadrants with low/high x and
+ * low/high y.
+ * */
+class HashLifeGameBoard : public AbstractGameBoard {
+ public:
+  // Once the node cache holds more than `max_nodes` nodes, the nodes that are
+  // no longer reachable from the board are garbage collected. Throws
+  // std::invalid_argument for rules with B0, since they bring empty space to
+  // life.
+  HashLifeGameBoard(int x_size, int y_size,
+                    size_t max_nodes = HASHLIFE_MAX_NODES,
+                    const Rule& rule = Rule());
+  std::pair<int, int> get_board_size() const;
+  const Rule& get_rule() const { return rule_; }
+  bool get_cell_state(int x, int y) const;
+  void set_cell_state(int x, int y, bool state);
+  void read_state_from(std::vector<bool>& vec);
+
+  void update();
+  void clear();
+  // Advance `generations` rounds as a sequence of power-of-two jumps, as
+  // large as the distance of the live cells from the edge allows, skipping
+  // whole periods once the board repeats
+  void advance(uint64_t generations);
+
+  int report_mem_usage();
+
+  // Every node counts its live cells, and the root is clipped to the board
+  uint64_t population() const { return root_->population; }
+  BoundingBox bounding_box() const;
+
+  // Number of nodes currently in the node cache
+  size_t node_count() const { return nodes_.size(); }
+  // Drop all nodes that are not reachable from the board
+  void collect_garbage();
+
+ protected:
+  int count_live_neighbors(int x, int y);
+  bool calculate_next_state(int x, int y);
+
+ private:
+  struct Node {
+    const Node* nw;  // The four quadrants, null for leaves (single cells)
+    const Node* ne;
+    const Node* sw;
+    const Node* se;
+    int level;            // The node covers 2^level x 2^level cells
+    uint64_t population;  // Number of live cells
+
+    // Memoized RESULT and the log2 of the generations it advances
+    mutable const Node* result = nullptr;
+    mutable int result_step = -1;
+    mutable bool marked = false;  // Reachability, used by the GC
+  };
+  struct NodeHash {
+    size_t operator()(const Node& node) const;
+  };
+  struct NodeEqual {
+    bool operator()(const Node& a, const Node& b) const;
+  };
+
+  // The canonical node with the given quadrants
+  const Node* join(const Node* nw, const Node* ne, const Node* sw,
+                   const Node* se);
+  // The canonical empty node of the given level
+  const Node* empty(int level);
+  // The center 2^(level-1) square of a node
+  const Node* center(const Node* node);
+  // The 2^(level-1) square straddling the border of two nodes side by side
+  const Node* horizontal_center(const Node* w, const Node* e);
+  // The 2^(level-1) square straddling the border of two stacked nodes
+  const Node* vertical_center(const Node* n, const Node* s);
+  // Surround the root with empty space, keeping it centered
+  void expand();
+
+  // The center of `node` advanced min(2^step_, 2^(level-2)) generations
+  const Node* successor(const Node* node);
+  // Successor of a 4x4 node: its center 2x2 cells one generation later
+  const Node* base_successor(const Node* node);
+  // Advance the board 2^step generations
+  void jump(int step);
+
+  // Build the node of `level` whose top left cell is (x, y) from `vec`
+  const Node* build(const std::vector<bool>& vec, int level, int64_t x,
+                    int64_t y);
+  // Remove all live cells outside the board from `node`, whose top left cell
+  // is at (x, y)
+  const Node* clip(const Node* node, int64_t x, int64_t y);
+  // Return `node` with the cell (x, y), relative to the node, set to `state`
+  const Node* set_cell(const Node* node, int64_t x, int64_t y, bool state);
+  bool get_cell(const Node* node, int64_t x, int64_t y) const;
+  // Grow `box` to the live cells of `node`, whose top left cell is at (x, y)
+  void add_to_box(const Node* node, int64_t x, int64_t y,
+                  BoundingBox& box) const;
+
+  void mark(const Node* node);
+
+  int x_size_, y_size_;  // The size of the board
+  size_t max_nodes_;     // Soft limit of the node cache
+  Rule rule_;            // The rule of the game
+
+  std::unordered_set<Node, NodeHash, NodeEqual> nodes_;  // The node cache
+  Node dead_leaf_, alive_leaf_;                          // The two cells
+  std::vector<const Node*> empties_;  // empties_[k] is empty(k)
+
+  // Between operations the root always has level base_level_ and its top
+  // left cell at (0, 0), so it covers the whole board
+  int base_level_;
+  const Node* root_;
+  // The roots of the last single generations of advance(), to detect a
+  // periodic board
+  std::vector<const Node*> recent_roots_;
+  int step_;  // log2 of the generations the current RESULTs advance
+};
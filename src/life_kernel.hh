@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+
+// Force inlining so the kernel can be instantiated inside functions that are
+// compiled for a wider target ISA (see the SIMD boards).
+#define LIFE_KERNEL_INLINE __attribute__((always_inline)) inline
+
+/**
+ * Bit-sliced Game of Life kernel.
+ *
+ * Every bit of a word is one cell, so a single pass through the adder network
+ * below computes the next state of 64 cells at once. The functions are
+ * templates over the word type `W` so that the same network can be evaluated
+ * on wider vector types. Arguments are passed by reference on purpose: passing
+ * vector types by value across ISA boundaries changes the ABI.
+ * */
+
+// Bit j of `out` holds the cell at position j-1, i.e. the neighbour on the
+// lower side. `prev` is the word holding the 64 cells before `word`.
+template <typename W>
+LIFE_KERNEL_INLINE void shift_from_prev(W& out, const W& word, const W& prev) {
+  out = (word << 1) | (prev >> 63);
+}
+
+// Bit j of `out` holds the cell at position j+1, i.e. the neighbour on the
+// upper side. `next` is the word holding the 64 cells after `word`.
+template <typename W>
+LIFE_KERNEL_INLINE void shift_from_next(W& out, const W& word, const W& next) {
+  out = (word >> 1) | (next << 63);
+}
+
+template <typename W>
+LIFE_KERNEL_INLINE void half_add(W& sum, W& carry, const W& a, const W& b) {
+  sum = a ^ b;
+  carry = a & b;
+}
+
+template <typename W>
+LIFE_KERNEL_INLINE void full_add(W& sum, W& carry, const W& a, const W& b,
+                                 const W& c) {
+  W t = a ^ b;
+  sum = t ^ c;
+  carry = (a & b) | (t & c);
+}
+
+// Count the eight neighbours of every cell in `mid`. The count is returned as
+// four bit planes: count = s0 + 2 * s1 + 4 * s2 + 8 * s3.
+// `up`/`down` are the rows above and below; `*_prev`/`*_next` are the words
+// adjacent to each of the three words in the same row.
+template <typename W>
+LIFE_KERNEL_INLINE void count_neighbors(W& s0, W& s1, W& s2, W& s3,
+                                        const W& up_prev, const W& up,
+                                        const W& up_next, const W& mid_prev,
+                                        const W& mid, const W& mid_next,
+                                        const W& down_prev, const W& down,
+                                        const W& down_next) {
+  W up_l, up_r, mid_l, mid_r, down_l, down_r;
+  shift_from_prev(up_l, up, up_prev);
+  shift_from_next(up_r, up, up_next);
+  shift_from_prev(mid_l, mid, mid_prev);
+  shift_from_next(mid_r, mid, mid_next);
+  shift_from_prev(down_l, down, down_prev);
+  shift_from_next(down_r, down, down_next);
+
+  // Column sums of the row above (3 cells), below (3 cells) and the current
+  // row (2 cells, the cell itself is excluded).
+  W up_s, up_c, down_s, down_c, mid_s, mid_c;
+  full_add(up_s, up_c, up_l, up, up_r);
+  full_add(down_s, down_c, down_l, down, down_r);
+  half_add(mid_s, mid_c, mid_l, mid_r);
+
+  // Ones place, then reduce the four weight-2 carries.
+  W c1, t, u, v;
+  full_add(s0, c1, up_s, down_s, mid_s);
+  full_add(t, u, up_c, down_c, mid_c);
+  half_add(s1, v, t, c1);
+  half_add(s2, s3, u, v);
+}
+
+// Next generation of the cells in `mid` under B3/S23: a cell is alive next
+// round iff it has 3 neighbours, or it is alive and has 2 neighbours. The
+// eights plane is not needed: a count of 8 already has s1 cleared.
+template <typename W>
+LIFE_KERNEL_INLINE void life_kernel(W& out, const W& up_prev, const W& up,
+                                    const W& up_next, const W& mid_prev,
+                                    const W& mid, const W& mid_next,
+                                    const W& down_prev, const W& down,
+                                    const W& down_next) {
+  W s0, s1, s2, s3;
+  count_neighbors(s0, s1, s2, s3, up_prev, up, up_next, mid_prev, mid,
+                  mid_next, down_prev, down, down_next);
+  out = s1 & ~s2 & (s0 | mid);
+}
+
+// Next generation of the cells in `mid` under the Life-like rule `R`, which
+// has birth() and survival() masks (see rule.hh). Each neighbour count the
+// rule uses is matched against the four bit planes. When the masks are
+// compile-time constants (StaticRule), the counts the rule does not use are
+// folded away, and B3/S23 uses the shortcut of life_kernel.
+template <typename R, typename W>
+LIFE_KERNEL_INLINE void rule_kernel(W& out, const R& rule, const W& up_prev,
+                                    const W& up, const W& up_next,
+                                    const W& mid_prev, const W& mid,
+                                    const W& mid_next, const W& down_prev,
+                                    const W& down, const W& down_next) {
+  const uint16_t birth = rule.birth(), survival = rule.survival();
+  if (birth == (1 << 3) && survival == (1 << 2 | 1 << 3)) {
+    life_kernel(out, up_prev, up, up_next, mid_prev, mid, mid_next, down_prev,
+                down, down_next);
+    return;
+  }
+  W s0, s1, s2, s3;
+  count_neighbors(s0, s1, s2, s3, up_prev, up, up_next, mid_prev, mid,
+                  mid_next, down_prev, down, down_next);
+  W born = mid ^ mid, survive = mid ^ mid;
+  for (int n = 0; n <= 8; n++) {
+    if ((((birth | survival) >> n) & 1) == 0) {
+      continue;
+    }
+    // The cells with exactly n live neighbours
+    W count = (n & 1) ? s0 : ~s0;
+    count &= (n & 2) ? s1 : ~s1;
+    count &= (n & 4) ? s2 : ~s2;
+    count &= (n & 8) ? s3 : ~s3;
+    if ((birth >> n) & 1) {
+      born |= count;
+    }
+    if ((survival >> n) & 1) {
+      survive |= count;
+    }
+  }
+  out = (born & ~mid) | (survive & mid);
+}
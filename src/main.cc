@@ -1,7 +1,14 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <fstream>
+
+#include "board_factory.hh"
+#include "cli.hh"
 #include "game.hh"
+#include "multi_state_game_board.hh"
+#include "pattern_io.hh"
+#include "snapshot.hh"
 // include for std::tie
 #include <tuple>
 
@@ -75,7 +82,25 @@ void god_function3(AbstractGameBoard* board) {
   }
 }
 
-void test(int x_size, int y_size, int rounds) {
+// Run `rounds` rounds on `game_board` starting from `vec`, then report its
+// memory usage and CPU time under `name`. Without `headless` the rounds are
+// shown in a window.
+void run_board(const std::string& name, AbstractGameBoard* game_board,
+               std::vector<bool>& vec,
+               std::vector<void (*)(AbstractGameBoard*)> god_functions,
+               int rounds, bool headless) {
+  game_board->read_state_from(vec);
+  Game game(game_board, god_functions, true, 0, rounds, headless);
+  game.run();
+  std::cout << name << " occupied " << game_board->report_mem_usage()
+            << " bytes of memory." << std::endl;
+  std::cout << name << " costs " << game.report_CPU_time() / 1000 << " ms."
+            << std::endl;
+}
+
+// Compare all engines on a random board of `x_size` x `y_size` cells, in a
+// window unless `headless` is set
+void test(int x_size, int y_size, int rounds, bool headless) {
   std::vector<bool> vec(x_size * y_size);
   for (uint64_t i = 0; i < vec.size(); i++) {
     if (rand() < RAND_MAX / 2) {
@@ -97,37 +122,203 @@ void test(int x_size, int y_size, int rounds) {
     {
       AbstractGameBoard* game_board =
           new FullyOptimizedGameBoard(x_size, y_size);
-      Game game(game_board, god_functions, true, 0, rounds);
-      game_board->read_state_from(vec);
-      game.run();
-      std::cout << "Optimized GameBoard occupied "
-                << game_board->report_mem_usage() << " bytes of memory."
+      run_board("Optimized GameBoard", game_board, vec, god_functions, rounds,
+                headless);
+      delete game_board;
+    }
+    {
+      AbstractGameBoard* game_board = new BitSlicedGameBoard(x_size, y_size);
+      run_board("BitSliced GameBoard", game_board, vec, god_functions, rounds,
+                headless);
+      delete game_board;
+    }
+    {
+      AbstractGameBoard* game_board = new LutGameBoard(x_size, y_size);
+      run_board("LUT GameBoard", game_board, vec, god_functions, rounds,
+                headless);
+      delete game_board;
+    }
+    {
+      AbstractGameBoard* game_board =
+          new MultiStateGameBoard(x_size, y_size);
+      run_board("MultiState GameBoard", game_board, vec, god_functions,
+                rounds, headless);
+      delete game_board;
+    }
+    {
+      SimdGameBoard* game_board = new SimdGameBoard(x_size, y_size);
+      run_board(std::string("SIMD (") + simd_isa_name(game_board->get_isa()) +
+                    ") GameBoard",
+                game_board, vec, god_functions, rounds, headless);
+      delete game_board;
+    }
+    {
+      TiledGameBoard* game_board = new TiledGameBoard(x_size, y_size);
+      run_board("Tiled GameBoard", game_board, vec, god_functions, rounds,
+                headless);
+      std::cout << "Tiled GameBoard recomputed "
+                << game_board->report_active_tiles() << " tiles and skipped "
+                << game_board->report_skipped_tiles() << " tiles."
                 << std::endl;
-      std::cout << "Optimized GameBoard costs " << game.report_CPU_time() / 1000
-                << " ms." << std::endl;
       delete game_board;
     }
     exit(0);
   } else {
     // Parent process
     AbstractGameBoard* game_board = new GameBoard(x_size, y_size);
-    game_board->read_state_from(vec);
-    Game game(game_board, god_functions, true, 0, rounds);
-    game.run();
-    std::cout << "Unoptimized GameBoard occupied "
-              << game_board->report_mem_usage() << " bytes of memory."
-              << std::endl;
-    std::cout << "Unoptimized GameBoard costs " << game.report_CPU_time() / 1000
-              << " ms." << std::endl;
+    run_board("Unoptimized GameBoard", game_board, vec, god_functions, rounds,
+              headless);
     delete game_board;
   }
   wait(nullptr);
 }
 
-int main() {
-  srand(10808);  // Set the seed for the random number generator
-  std::cout << "------- Verification Test ---------" << std::endl;
-  test(256, 256, 100);
-  std::cout << "------- Speed Test ---------" << std::endl;
-  test(2048, 2048, 1000);
+// Apply the god functions picked by `options` to `board`
+void apply_gods(const Options& options,
+                std::vector<void (*)(AbstractGameBoard*)>& god_functions,
+                AbstractGameBoard* board) {
+  for (int god : options.gods) {
+    if (god < 0 || god >= static_cast<int>(god_functions.size())) {
+      throw std::invalid_argument("No god function " + std::to_string(god));
+    }
+    god_functions[god](board);
+  }
+}
+
+// Build the board configured by `options` and seed it with the snapshot, the
+// pattern or a random state. `generation` is set to the generation the
+// board is at, and a snapshot sets the size and rule of `options`.
+std::unique_ptr<AbstractGameBoard> make_seeded_board(
+    Options& options,
+    std::vector<void (*)(AbstractGameBoard*)>& god_functions,
+    uint64_t& generation) {
+  generation = 0;
+  if (!options.restore_file.empty()) {
+    SnapshotInfo info = read_snapshot_info(options.restore_file);
+    options.x_size = info.x_size;
+    options.y_size = info.y_size;
+    options.rule = info.rule.to_string();
+    std::unique_ptr<AbstractGameBoard> board = make_game_board(
+        options.engine, info.x_size, info.y_size, info.rule, options.threads);
+    generation = load_snapshot(options.restore_file, *board).generation;
+    apply_gods(options, god_functions, board.get());
+    return board;
+  }
+  std::unique_ptr<AbstractGameBoard> board =
+      make_game_board(options.engine, options.x_size, options.y_size,
+                      MultiStateRule::parse(options.rule), options.threads);
+  srand(options.seed);
+  if (!options.pattern_file.empty()) {
+    PatternInfo info = load_pattern(options.pattern_file, *board,
+                                    options.pattern_x, options.pattern_y);
+    if (info.clipped_cells) {
+      std::cerr << info.clipped_cells << " live cells of "
+                << options.pattern_file << " fell outside of the board"
+                << std::endl;
+    }
+  } else {
+    std::vector<bool> vec((uint64_t)options.x_size * options.y_size);
+    for (uint64_t i = 0; i < vec.size(); i++) {
+      if (rand() < RAND_MAX * options.density) {
+        vec[i] = true;
+      }
+    }
+    board->read_state_from(vec);
+  }
+  apply_gods(options, god_functions, board.get());
+  return board;
+}
+
+// Run the simulation configured by `options` without touching SDL
+void run_headless(Options& options,
+                  std::vector<void (*)(AbstractGameBoard*)>& god_functions) {
+  if (!options.save_file.empty()) {
+    pattern_format_of(options.save_file);  // Fail before the run, not after
+  }
+  uint64_t generation;
+  std::unique_ptr<AbstractGameBoard> board =
+      make_seeded_board(options, god_functions, generation);
+  Game game(board.get(), god_functions, true, 0,
+            generation + options.generations, true);
+  game.resume_at(generation);
+  if (!options.checkpoint_file.empty()) {
+    game.set_checkpoints(options.checkpoint_file, options.checkpoint_every,
+                         options.checkpoint_tiles,
+                         size_t(options.checkpoint_memory_mb) << 20);
+  }
+  std::ofstream metrics;
+  if (!options.metrics_file.empty()) {
+    metrics.open(options.metrics_file);
+    if (!metrics) {
+      throw std::invalid_argument("Cannot write " + options.metrics_file);
+    }
+    game.set_metrics(options.metrics_sample, &metrics, options.metrics_every);
+  }
+  game.run();
+  if (metrics.is_open()) {
+    metrics << game.metrics().to_json() << std::endl;
+  }
+  if (!options.save_file.empty()) {
+    save_pattern(options.save_file, *board);
+  }
+  const uint64_t last = generation + options.generations;
+  if (!options.checkpoint_file.empty()) {
+    if (options.checkpoint_every == 0 || last % options.checkpoint_every) {
+      game.checkpoint();
+    }
+    game.wait_for_checkpoints();
+  }
+
+  RunReport report;
+  report.generations = options.generations;
+  report.cpu_time_us = game.report_CPU_time();
+  report.population = board->population();
+  report.mem_usage = board->report_mem_usage();
+  write_report(std::cout, options, report);
+}
+
+int main(int argc, char** argv) {
+  if (argc == 1) {
+    srand(10808);  // Set the seed for the random number generator
+    std::cout << "------- Verification Test ---------" << std::endl;
+    test(256, 256, 100, false);
+    std::cout << "------- Speed Test ---------" << std::endl;
+    // Too large for a window before the viewport existed, and timed alone
+    test(2048, 2048, 1000, true);
+    return 0;
+  }
+
+  std::vector<void (*)(AbstractGameBoard*)> god_functions;
+  god_functions.push_back(god_function1);
+  god_functions.push_back(god_function2);
+  god_functions.push_back(god_function3);
+  try {
+    Options options = parse_options(argc, argv);
+    if (options.help) {
+      std::cout << usage(argv[0]);
+      return 0;
+    }
+    if (options.headless) {
+      run_headless(options, god_functions);
+    } else {
+      // Interactive: the board starts paused and runs until the window is
+      // closed
+      uint64_t generation;
+      std::unique_ptr<AbstractGameBoard> board =
+          make_seeded_board(options, god_functions, generation);
+      Game game(board.get(), god_functions, false, 0,
+                generation + options.generations);
+      game.resume_at(generation);
+      game.set_gens_per_sec(options.gens_per_sec);
+      game.set_gens_per_frame(options.gens_per_frame);
+      game.run();
+    }
+  } catch (const std::invalid_argument& e) {
+    std::cerr << e.what() << std::endl << std::endl << usage(argv[0]);
+    return 1;
+  } catch (const std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "metrics.hh"
+
+#include <algorithm>
+#include <sstream>
+
+#include "game_board.hh"
+
+int LatencyHistogram::bucket_of(int64_t ns) {
+  if (ns < kExactBuckets) {
+    return std::max<int64_t>(ns, 0);
+  }
+  const int exponent = 63 - __builtin_clzll(ns);  // At least 4
+  const int sub = (ns >> (exponent - 3)) & (kSubBuckets - 1);
+  return kExactBuckets + (exponent - 4) * kSubBuckets + sub;
+}
+
+int64_t LatencyHistogram::bucket_end(int bucket) {
+  if (bucket < kExactBuckets) {
+    return bucket;
+  }
+  const int exponent = (bucket - kExactBuckets) / kSubBuckets + 4;
+  const int sub = (bucket - kExactBuckets) % kSubBuckets;
+  // The bucket covers [(8 + sub) << (exponent - 3), (9 + sub) << ...)
+  const uint64_t end = uint64_t(kSubBuckets + sub + 1) << (exponent - 3);
+  return end - 1 > uint64_t(INT64_MAX) ? INT64_MAX : int64_t(end - 1);
+}
+
+void LatencyHistogram::record(int64_t ns) {
+  buckets_[bucket_of(ns)]++;
+  count_++;
+  sum_ += ns;
+  min_ = std::min(min_, ns);
+  max_ = std::max(max_, ns);
+}
+
+void LatencyHistogram::clear() { *this = LatencyHistogram(); }
+
+int64_t LatencyHistogram::percentile(double p) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  // The rank of the value, 1-based
+  const uint64_t rank =
+      std::max<uint64_t>(1, std::min<uint64_t>(count_, p * count_ + 0.5));
+  uint64_t seen = 0;
+  for (int bucket = 0; bucket < kBuckets; bucket++) {
+    seen += buckets_[bucket];
+    if (seen >= rank) {
+      return std::min(bucket_end(bucket), max_);
+    }
+  }
+  return max_;
+}
+
+std::string LatencyHistogram::to_json() const {
+  std::stringstream json;
+  json << "{\"count\": " << count_ << ", \"min_us\": " << min() / 1e3
+       << ", \"mean_us\": " << mean() / 1e3
+       << ", \"p50_us\": " << percentile(0.5) / 1e3
+       << ", \"p90_us\": " << percentile(0.9) / 1e3
+       << ", \"p99_us\": " << percentile(0.99) / 1e3
+       << ", \"p999_us\": " << percentile(0.999) / 1e3
+       << ", \"max_us\": " << max_ / 1e3 << "}";
+  return json.str();
+}
+
+void Metrics::record_generation(AbstractGameBoard& board,
+                                int64_t update_ns) {
+  const UpdateProfile& profile = board.last_update_profile();
+  update_.record(update_ns);
+  swap_.record(profile.swap_ns);
+  sync_.record(profile.sync_ns);
+  compute_.record(
+      std::max<int64_t>(update_ns - profile.swap_ns - profile.sync_ns, 0));
+
+  generations_++;
+  if (sample_every_ > 0 && generations_ % sample_every_ == 0) {
+    population_ = board.population();
+    active_cells_ = board.active_cells();
+    mem_usage_ = board.report_mem_usage();
+    peak_mem_usage_ = std::max(peak_mem_usage_, mem_usage_);
+  }
+}
+
+void Metrics::clear() { *this = Metrics(sample_every_); }
+
+std::string Metrics::to_json() const {
+  std::stringstream json;
+  json << "{\"generations\": " << generations_
+       << ", \"update\": " << update_.to_json()
+       << ", \"compute\": " << compute_.to_json()
+       << ", \"swap\": " << swap_.to_json()
+       << ", \"sync\": " << sync_.to_json()
+       << ", \"population\": " << population_
+       << ", \"active_cells\": " << active_cells_
+       << ", \"mem_bytes\": " << mem_usage_
+       << ", \"peak_mem_bytes\": " << peak_mem_usage_ << "}";
+  return json.str();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+class AbstractGameBoard;
+
+// Nanoseconds on a monotonic clock, for timing the phases of update()
+inline int64_t profile_clock_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Where the last update() of a board spent its time. Boards only record the
+// phases they have; whatever is not swap or sync is compute.
+struct UpdateProfile {
+  int64_t swap_ns = 0;  // Flipping buffers and other bookkeeping
+  int64_t sync_ns = 0;  // Waiting for other threads
+};
+
+/**
+ * Histogram of latencies in nanoseconds with a bounded relative error.
+ *
+ * Values below 16 ns have a bucket each; above that every power of two is
+ * split into 8 buckets, so a percentile is off by at most 12.5%. Recording
+ * is a few instructions and the histogram has a fixed size, so it can be
+ * fed every generation of arbitrarily long runs.
+ * */
+class LatencyHistogram {
+ public:
+  void record(int64_t ns);
+  void clear();
+
+  uint64_t count() const { return count_; }
+  int64_t min() const { return count_ ? min_ : 0; }
+  int64_t max() const { return max_; }
+  double mean() const { return count_ ? double(sum_) / count_ : 0; }
+  // The smallest recorded value which `p` (in [0, 1]) of the values are at
+  // or below, rounded up to the end of its bucket
+  int64_t percentile(double p) const;
+
+  // {"count": ..., "min_us": ..., "mean_us": ..., "p50_us": ..., ...}
+  std::string to_json() const;
+
+ private:
+  static constexpr int kExactBuckets = 16;
+  static constexpr int kSubBuckets = 8;  // Per power of two
+  static constexpr int kBuckets = kExactBuckets + (63 - 4 + 1) * kSubBuckets;
+
+  static int bucket_of(int64_t ns);
+  // The largest value falling into `bucket`
+  static int64_t bucket_end(int bucket);
+
+  std::array<uint64_t, kBuckets> buckets_{};
+  uint64_t count_ = 0;
+  int64_t sum_ = 0;
+  int64_t min_ = INT64_MAX;
+  int64_t max_ = 0;
+};
+
+/**
+ * Per-generation metrics of a run.
+ *
+ * The latency of every update() and its split into compute, swap and sync
+ * (see UpdateProfile) go into histograms. The population, the active region
+ * (cells the board actually visited) and the memory usage of the board are
+ * sampled every `sample_every` generations, since asking a board for its
+ * population may cost as much as a generation.
+ * */
+class Metrics {
+ public:
+  // A `sample_every` of 0 never samples the board
+  explicit Metrics(int sample_every = 1) : sample_every_(sample_every) {}
+
+  // Record the generation `board` just computed in `update_ns`
+  void record_generation(AbstractGameBoard& board, int64_t update_ns);
+  void clear();
+
+  uint64_t generations() const { return generations_; }
+  const LatencyHistogram& update_latency() const { return update_; }
+  const LatencyHistogram& compute_latency() const { return compute_; }
+  const LatencyHistogram& swap_latency() const { return swap_; }
+  const LatencyHistogram& sync_latency() const { return sync_; }
+
+  // The last sample of the board
+  uint64_t population() const { return population_; }
+  uint64_t active_cells() const { return active_cells_; }
+  int64_t mem_usage() const { return mem_usage_; }
+  int64_t peak_mem_usage() const { return peak_mem_usage_; }
+
+  // All metrics as one JSON object on a single line
+  std::string to_json() const;
+
+ private:
+  int sample_every_;
+  uint64_t generations_ = 0;
+  LatencyHistogram update_, compute_, swap_, sync_;
+  uint64_t population_ = 0;
+  uint64_t active_cells_ = 0;
+  int64_t mem_usage_ = 0;
+  int64_t peak_mem_usage_ = 0;
+};
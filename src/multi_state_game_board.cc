@@ -0,0 +1,149 @@
+#include "multi_state_game_board.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+MultiStateGameBoard::MultiStateGameBoard(int x_size, int y_size,
+                                         const MultiStateRule& rule)
+    : x_size_(x_size),
+      y_size_(y_size),
+      rule_(rule),
+      cells_(x_size * y_size, 0),
+      next_cells_(x_size * y_size, 0),
+      column_sums_(y_size + 2 * rule.radius() + 1, 0) {
+  if (rule.is_life_like()) {
+    life_like_rule_ = rule.to_life_like();
+  }
+  const int side = 2 * rule.radius() + 1;
+  window_cells_ = side * side + 1;
+  transitions_.resize(rule.states() * window_cells_);
+  for (int state = 0; state < rule.states(); state++) {
+    for (int live = 0; live < window_cells_; live++) {
+      // An alive cell is in its own window, but only counts as its own
+      // neighbour under M1
+      const int count = live - (state == 1 && !rule.counts_center());
+      if (count < 0 || count > rule.max_count()) {
+        continue;  // Cannot happen
+      }
+      uint8_t next;
+      if (state == 0) {
+        next = rule.births(count) ? 1 : 0;
+      } else if (state == 1) {
+        next = rule.survives(count) ? 1 : (rule.states() > 2 ? 2 : 0);
+      } else {
+        next = state + 1 == rule.states() ? 0 : state + 1;
+      }
+      transitions_[state * window_cells_ + live] = next;
+    }
+  }
+}
+
+std::pair<int, int> MultiStateGameBoard::get_board_size() const {
+  return std::make_pair(x_size_, y_size_);
+}
+
+const Rule& MultiStateGameBoard::get_rule() const {
+  if (!rule_.is_life_like()) {
+    throw std::logic_error(rule_.to_string() + " is not a Life-like rule");
+  }
+  return life_like_rule_;
+}
+
+bool MultiStateGameBoard::get_cell_state(int x, int y) const {
+  return get_state(x, y) == 1;
+}
+
+void MultiStateGameBoard::set_cell_state(int x, int y, bool state) {
+  cells_[x * y_size_ + y] = state;
+}
+
+void MultiStateGameBoard::set_state(int x, int y, uint8_t state) {
+  assert(state < rule_.states());
+  cells_[x * y_size_ + y] = state;
+}
+
+void MultiStateGameBoard::read_state_from(std::vector<bool>& vec) {
+  assert(vec.size() == (uint64_t)(x_size_ * y_size_));
+  for (size_t i = 0; i < vec.size(); i++) {
+    cells_[i] = vec[i];
+  }
+}
+
+void MultiStateGameBoard::clear() {
+  std::fill(cells_.begin(), cells_.end(), 0);
+}
+
+void MultiStateGameBoard::update() {
+  const int radius = rule_.radius();
+  const uint8_t* cells = cells_.data();
+  const uint8_t* transitions = transitions_.data();
+  int* columns = column_sums_.data();
+  std::fill(column_sums_.begin(), column_sums_.end(), 0);
+
+  // Add (sign 1) or remove (sign -1) the live cells of row x to the column
+  // sums; column y of the board is at columns[y + radius]
+  auto add_row = [&](int x, int sign) {
+    const uint8_t* row = cells + x * y_size_;
+    for (int y = 0; y < y_size_; y++) {
+      columns[y + radius] += sign * (row[y] == 1);
+    }
+  };
+  for (int x = 0; x < std::min(radius, x_size_); x++) {
+    add_row(x, 1);
+  }
+
+  for (int x = 0; x < x_size_; x++) {
+    // Slide the window down to rows [x - radius, x + radius]
+    if (x + radius < x_size_) {
+      add_row(x + radius, 1);
+    }
+    if (x - radius - 1 >= 0) {
+      add_row(x - radius - 1, -1);
+    }
+    // Slide the window along the row: the window of column y covers the
+    // column sums [y, y + 2 * radius]
+    int live = 0;
+    for (int y = 0; y < 2 * radius; y++) {
+      live += columns[y];
+    }
+    const uint8_t* row = cells + x * y_size_;
+    uint8_t* out = next_cells_.data() + x * y_size_;
+    for (int y = 0; y < y_size_; y++) {
+      live += columns[y + 2 * radius];
+      out[y] = transitions[row[y] * window_cells_ + live];
+      live -= columns[y];
+    }
+  }
+  std::swap(cells_, next_cells_);
+}
+
+int MultiStateGameBoard::count_live_neighbors(int x, int y) {
+  const int radius = rule_.radius();
+  int count = 0;
+  for (int i = std::max(x - radius, 0); i <= std::min(x + radius, x_size_ - 1);
+       i++) {
+    for (int j = std::max(y - radius, 0);
+         j <= std::min(y + radius, y_size_ - 1); j++) {
+      count += get_state(i, j) == 1;
+    }
+  }
+  if (!rule_.counts_center()) {
+    count -= get_state(x, y) == 1;
+  }
+  return count;
+}
+
+bool MultiStateGameBoard::calculate_next_state(int x, int y) {
+  int live = count_live_neighbors(x, y);
+  // Back to the sum over the window, which the table is indexed by
+  if (!rule_.counts_center()) {
+    live += get_state(x, y) == 1;
+  }
+  return transitions_[get_state(x, y) * window_cells_ + live] == 1;
+}
+
+int MultiStateGameBoard::report_mem_usage() {
+  return cells_.size() + next_cells_.size() + transitions_.size() +
+         column_sums_.size() * sizeof(int);
+}
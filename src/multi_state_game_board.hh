@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game_board.hh"
+
+/**
+ * Game board for multi-state rules: Generations and Larger than Life (see
+ * MultiStateRule).
+ *
+ * Every cell is one byte holding its state. The live cells in the square
+ * around a cell are counted with a sliding window: a column sum per y is
+ * updated by adding the row entering the window and removing the row
+ * leaving it, and a running sum over the column sums slides along the row.
+ * Counting therefore costs O(1) per cell for any radius. The next state is
+ * looked up in a table indexed by the current state and the count.
+ *
+ * Cells outside the board are dead. get_cell_state() reports whether a cell
+ * is alive (state 1); get_state() returns the full state.
+ * */
+class MultiStateGameBoard : public AbstractGameBoard {
+ public:
+  MultiStateGameBoard(int x_size, int y_size,
+                      const MultiStateRule& rule = MultiStateRule());
+  std::pair<int, int> get_board_size() const;
+  bool get_cell_state(int x, int y) const;
+  void set_cell_state(int x, int y, bool state);
+  void read_state_from(std::vector<bool>& vec);
+
+  void update();
+  void clear();
+
+  // Only Life-like rules can be returned as a Rule, throws std::logic_error
+  // for other rules
+  const Rule& get_rule() const;
+  const MultiStateRule& get_multi_state_rule() const { return rule_; }
+
+  // The state of a cell: 0 is dead, 1 is alive and 2 onwards are dying
+  uint8_t get_state(int x, int y) const { return cells_[x * y_size_ + y]; }
+  void set_state(int x, int y, uint8_t state);
+
+  int report_mem_usage();
+
+ protected:
+  int count_live_neighbors(int x, int y);
+  bool calculate_next_state(int x, int y);
+
+ private:
+  int x_size_, y_size_;  // The size of the board
+  MultiStateRule rule_;
+  Rule life_like_rule_;  // The rule as a Rule, if it is Life-like
+
+  std::vector<uint8_t> cells_;       // The current generation
+  std::vector<uint8_t> next_cells_;  // The next generation
+  // transitions_[state * window_cells_ + live] is the next state of a cell
+  // in `state` with `live` alive cells in its window, including itself
+  std::vector<uint8_t> transitions_;
+  int window_cells_;  // Number of possible window sums, (2R+1)^2 + 1
+  // Live cells per y in the rows of the window, with `radius` dead columns
+  // on either side
+  std::vector<int> column_sums_;
+};
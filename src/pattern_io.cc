@@ -0,0 +1,432 @@
+#include "pattern_io.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Lines of an RLE file are kept below this length, as the format asks
+constexpr size_t kRleLineLength = 70;
+
+// Collects the cells of one pattern row as packed words and adds them to
+// the board when the row ends
+class RowWriter {
+ public:
+  RowWriter(AbstractGameBoard& board, int x, int y, PatternInfo& info)
+      : board_(board),
+        x_(x),
+        y_(y),
+        x_size_(board.get_board_size().first),
+        y_size_(board.get_board_size().second),
+        info_(info),
+        words_(board.packed_row_words(), 0) {}
+
+  // Append `count` cells to the current row
+  void add(int64_t count, bool alive) {
+    if (alive && count > 0) {
+      const int64_t row = x_ + row_;
+      // The cells [begin, end) of the board row, clipped to the board
+      const int64_t begin = std::max<int64_t>(y_ + column_, 0);
+      const int64_t end = std::min<int64_t>(y_ + column_ + count, y_size_);
+      if (row >= 0 && row < x_size_ && begin < end) {
+        fill(begin, end);
+        info_.live_cells += end - begin;
+        info_.clipped_cells += count - (end - begin);
+      } else {
+        info_.clipped_cells += count;
+      }
+    }
+    column_ += count;
+    if (column_ > INT_MAX) {
+      throw std::invalid_argument("Pattern row is too long");
+    }
+  }
+
+  // End the current row and skip `count - 1` empty rows
+  void end_rows(int64_t count) {
+    flush();
+    width_ = std::max(width_, column_);
+    row_ += count;
+    column_ = 0;
+    if (row_ > INT_MAX) {
+      throw std::invalid_argument("Pattern has too many rows");
+    }
+  }
+
+  // End the pattern
+  void finish() {
+    if (column_ > 0) {
+      end_rows(1);
+    }
+  }
+
+  // Extent of the cells read
+  int width() const { return width_; }
+  int height() const { return row_; }
+
+ private:
+  // Set the cells [begin, end) of the row
+  void fill(int64_t begin, int64_t end) {
+    for (int64_t k = begin / 64; k <= (end - 1) / 64; k++) {
+      const int lo = std::max(begin, k * 64) - k * 64;
+      const int hi = std::min(end, k * 64 + 64) - k * 64;
+      const uint64_t below_hi = hi == 64 ? ~0UL : (1UL << hi) - 1;
+      words_[k] |= below_hi & ~((1UL << lo) - 1);
+    }
+    dirty_begin_ = std::min<int64_t>(dirty_begin_, begin / 64);
+    dirty_end_ = std::max<int64_t>(dirty_end_, (end - 1) / 64 + 1);
+  }
+
+  // Add the words of the row to the board
+  void flush() {
+    const int row = x_ + row_;
+    for (int k = dirty_begin_; k < dirty_end_; k++) {
+      if (words_[k]) {
+        board_.set_word(row, k, board_.get_word(row, k) | words_[k]);
+        words_[k] = 0;
+      }
+    }
+    dirty_begin_ = INT_MAX;
+    dirty_end_ = 0;
+  }
+
+  AbstractGameBoard& board_;
+  const int x_, y_;              // Where the top left cell goes
+  const int x_size_, y_size_;    // Size of the board
+  PatternInfo& info_;
+  std::vector<uint64_t> words_;  // The current row, packed like the board
+  int dirty_begin_ = INT_MAX;    // The words of `words_` that may be set
+  int dirty_end_ = 0;
+  int64_t row_ = 0, column_ = 0;  // Position in the pattern
+  int64_t width_ = 0;
+};
+
+std::invalid_argument parse_error(const std::string& format, int line,
+                                  const std::string& why) {
+  return std::invalid_argument("Invalid " + format + " at line " +
+                               std::to_string(line) + ": " + why);
+}
+
+// Skip the rest of the line
+void skip_line(std::streambuf* in) {
+  int c;
+  while ((c = in->sbumpc()) != EOF && c != '\n') {
+  }
+}
+
+std::string trim(const std::string& s) {
+  size_t begin = s.find_first_not_of(" \t\r");
+  size_t end = s.find_last_not_of(" \t\r");
+  return begin == std::string::npos ? "" : s.substr(begin, end - begin + 1);
+}
+
+// Parse the RLE header "x = m, y = n, rule = abc" into `info`
+void parse_rle_header(const std::string& header, int line, PatternInfo& info) {
+  std::stringstream fields(header);
+  std::string field;
+  while (std::getline(fields, field, ',')) {
+    size_t equals = field.find('=');
+    if (equals == std::string::npos) {
+      throw parse_error("RLE", line, "expected key = value in the header");
+    }
+    const std::string key = trim(field.substr(0, equals));
+    const std::string value = trim(field.substr(equals + 1));
+    if (key == "x" || key == "y") {
+      if (value.empty() || value.size() > 9 ||
+          value.find_first_not_of("0123456789") != std::string::npos) {
+        throw parse_error("RLE", line, "invalid size " + value);
+      }
+      (key == "x" ? info.width : info.height) = std::stoi(value);
+    } else if (key == "rule") {
+      info.rule = value;
+    } else {
+      throw parse_error("RLE", line, "unknown header field " + key);
+    }
+  }
+}
+
+// The first position in [y, end) whose cell is not `alive`, or `end`.
+// `row` holds the words of a board row starting at word `first_word`.
+int run_end(const std::vector<uint64_t>& row, int first_word, int y, int end,
+            bool alive) {
+  while (y < end) {
+    uint64_t word = row[y / 64 - first_word];
+    // Set bits are the cells differing from `alive`, starting at y
+    uint64_t differ = (alive ? ~word : word) >> (y % 64);
+    if (differ) {
+      return std::min(end, y + __builtin_ctzll(differ));
+    }
+    y = (y / 64 + 1) * 64;
+  }
+  return end;
+}
+
+// Writes the tokens of an RLE body, wrapping the lines
+class RleTokenWriter {
+ public:
+  explicit RleTokenWriter(std::ostream& out) : out_(out) {}
+
+  void write(int64_t count, char tag) {
+    std::string token = (count > 1 ? std::to_string(count) : "") + tag;
+    if (line_length_ + token.size() > kRleLineLength) {
+      out_ << '\n';
+      line_length_ = 0;
+    }
+    out_ << token;
+    line_length_ += token.size();
+  }
+
+ private:
+  std::ostream& out_;
+  size_t line_length_ = 0;
+};
+
+// The rule of `board` if it is Life-like, "" otherwise
+std::string rule_of(const AbstractGameBoard& board) {
+  try {
+    return board.get_rule().to_string();
+  } catch (const std::logic_error&) {
+    return "";
+  }
+}
+
+}  // namespace
+
+PatternFormat pattern_format_of(const std::string& path) {
+  size_t dot = path.rfind('.');
+  std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (extension == ".rle") {
+    return PatternFormat::kRle;
+  }
+  if (extension == ".cells" || extension == ".txt") {
+    return PatternFormat::kPlaintext;
+  }
+  throw std::invalid_argument("Unknown pattern format of " + path +
+                              ", expected .rle or .cells");
+}
+
+PatternInfo read_rle(std::istream& is, AbstractGameBoard& board, int x,
+                     int y) {
+  std::streambuf* in = is.rdbuf();
+  PatternInfo info;
+  PatternInfo header;
+  RowWriter writer(board, x, y, info);
+  int line = 1;
+
+  // Comments and the header come before the cells
+  int c;
+  while ((c = in->sgetc()) != EOF) {
+    if (c == '#') {
+      skip_line(in);
+      line++;
+    } else if (c == 'x') {
+      std::string text;
+      while ((c = in->sbumpc()) != EOF && c != '\n') {
+        text += c;
+      }
+      parse_rle_header(text, line++, header);
+      break;
+    } else if (std::isspace(c)) {
+      line += in->sbumpc() == '\n';
+    } else {
+      break;
+    }
+  }
+
+  int64_t count = 0;  // The run count being read, 0 if there is none
+  while ((c = in->sbumpc()) != EOF && c != '!') {
+    if (std::isdigit(c)) {
+      count = count * 10 + (c - '0');
+      if (count > INT_MAX) {
+        throw parse_error("RLE", line, "run count is too large");
+      }
+      continue;
+    }
+    if (std::isspace(c)) {
+      line += c == '\n';
+      continue;
+    }
+    const int64_t run = count ? count : 1;
+    count = 0;
+    switch (c) {
+      case 'b':
+      case '.':
+        writer.add(run, false);
+        break;
+      case 'o':
+      case 'A':
+        writer.add(run, true);
+        break;
+      case '$':
+        writer.end_rows(run);
+        break;
+      case '#':
+        skip_line(in);
+        line++;
+        break;
+      default:
+        throw parse_error("RLE", line,
+                          std::string("unexpected '") + char(c) + "'");
+    }
+  }
+  writer.finish();
+
+  info.rule = header.rule;
+  info.width = header.width ? header.width : writer.width();
+  info.height = header.height ? header.height : writer.height();
+  return info;
+}
+
+PatternInfo read_plaintext(std::istream& is, AbstractGameBoard& board, int x,
+                           int y) {
+  std::streambuf* in = is.rdbuf();
+  PatternInfo info;
+  RowWriter writer(board, x, y, info);
+  int line = 1;
+  bool line_start = true;
+  // Consecutive cells of the same state are added as one run
+  bool run_alive = false;
+  int64_t run = 0;
+
+  int c;
+  while ((c = in->sbumpc()) != EOF) {
+    if (line_start && c == '!') {
+      skip_line(in);
+      line++;
+      continue;
+    }
+    if (c == '\r') {
+      continue;
+    }
+    if (c == '\n') {
+      writer.add(run, run_alive);
+      run = 0;
+      writer.end_rows(1);
+      line++;
+      line_start = true;
+      continue;
+    }
+    line_start = false;
+    bool alive;
+    if (c == '.') {
+      alive = false;
+    } else if (c == 'O' || c == '*') {
+      alive = true;
+    } else {
+      throw parse_error("plaintext", line,
+                        std::string("unexpected '") + char(c) + "'");
+    }
+    if (alive != run_alive) {
+      writer.add(run, run_alive);
+      run = 0;
+      run_alive = alive;
+    }
+    run++;
+  }
+  writer.add(run, run_alive);
+  writer.finish();
+
+  info.width = writer.width();
+  info.height = writer.height();
+  return info;
+}
+
+PatternInfo load_pattern(const std::string& path, AbstractGameBoard& board,
+                         int x, int y) {
+  PatternFormat format = pattern_format_of(path);
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  PatternInfo info = format == PatternFormat::kRle
+                         ? read_rle(in, board, x, y)
+                         : read_plaintext(in, board, x, y);
+  if (in.bad()) {
+    throw std::runtime_error("Failed to read " + path);
+  }
+  return info;
+}
+
+void write_rle(std::ostream& out, const AbstractGameBoard& board) {
+  const BoundingBox box = board.bounding_box();
+  const std::string rule = rule_of(board);
+  const int width = box.empty() ? 0 : box.y_max - box.y_min + 1;
+  const int height = box.empty() ? 0 : box.x_max - box.x_min + 1;
+  out << "x = " << width << ", y = " << height;
+  if (!rule.empty()) {
+    out << ", rule = " << rule;
+  }
+  out << '\n';
+
+  RleTokenWriter tokens(out);
+  int64_t pending_rows = 0;  // Row ends not written yet
+  const int first_word = box.empty() ? 0 : box.y_min / 64;
+  std::vector<uint64_t> row;
+  for (int x = box.x_min; !box.empty() && x <= box.x_max; x++) {
+    row.clear();
+    for (int k = first_word; k <= box.y_max / 64; k++) {
+      row.push_back(board.get_word(x, k));
+    }
+    // Runs up to the last live cell of the row, trailing dead cells are
+    // implied by the end of the row
+    int y = box.y_min;
+    while (true) {
+      int dead_end = run_end(row, first_word, y, box.y_max + 1, false);
+      if (dead_end > box.y_max) {
+        break;
+      }
+      if (pending_rows) {
+        tokens.write(pending_rows, '$');
+        pending_rows = 0;
+      }
+      if (dead_end > y) {
+        tokens.write(dead_end - y, 'b');
+      }
+      y = run_end(row, first_word, dead_end, box.y_max + 1, true);
+      tokens.write(y - dead_end, 'o');
+    }
+    pending_rows++;
+  }
+  tokens.write(1, '!');
+  out << '\n';
+}
+
+void write_plaintext(std::ostream& out, const AbstractGameBoard& board,
+                     const std::string& name) {
+  if (!name.empty()) {
+    out << "!Name: " << name << '\n';
+  }
+  const BoundingBox box = board.bounding_box();
+  if (box.empty()) {
+    return;
+  }
+  std::string line;
+  for (int x = box.x_min; x <= box.x_max; x++) {
+    line.clear();
+    for (int y = box.y_min; y <= box.y_max; y++) {
+      line += board.get_cell_state(x, y) ? 'O' : '.';
+    }
+    out << line << '\n';
+  }
+}
+
+void save_pattern(const std::string& path, const AbstractGameBoard& board) {
+  PatternFormat format = pattern_format_of(path);
+  std::ofstream out(path, std::ios::binary);
+  if (format == PatternFormat::kRle) {
+    write_rle(out, board);
+  } else {
+    write_plaintext(out, board);
+  }
+  out.flush();
+  if (!out) {
+    throw std::runtime_error("Cannot write " + path);
+  }
+}
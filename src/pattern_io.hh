@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "game_board.hh"
+
+// Pattern file formats: Run Length Encoded (.rle) and plaintext (.cells)
+enum class PatternFormat { kRle, kPlaintext };
+
+// What was read from a pattern file
+struct PatternInfo {
+  // Size of the pattern: from the RLE header if it has one, otherwise the
+  // extent of the cells read
+  int width = 0, height = 0;
+  std::string rule;            // The rule in the RLE header, if any
+  uint64_t live_cells = 0;     // Live cells placed on the board
+  uint64_t clipped_cells = 0;  // Live cells that fell outside of the board
+};
+
+// The format of `path` judged by its extension, throws std::invalid_argument
+// for other extensions
+PatternFormat pattern_format_of(const std::string& path);
+
+// Place the pattern read from `in` on `board` with its top left cell at
+// (x, y). Pattern rows run along x and pattern columns along y, so a row of
+// the pattern lands in the words of a board row. Live cells are added, the
+// cells of the board under dead cells of the pattern are left as they are,
+// and cells falling outside of the board are dropped.
+//
+// The input is parsed in a single pass through the stream buffer. Only the
+// row being read is kept, packed, and written to the board a word at a time,
+// so the memory needed does not depend on the size of the file.
+//
+// Throws std::invalid_argument for malformed input.
+PatternInfo read_rle(std::istream& in, AbstractGameBoard& board, int x = 0,
+                     int y = 0);
+PatternInfo read_plaintext(std::istream& in, AbstractGameBoard& board,
+                           int x = 0, int y = 0);
+// Open `path` and read it in the format given by its extension. Throws
+// std::runtime_error if the file cannot be read.
+PatternInfo load_pattern(const std::string& path, AbstractGameBoard& board,
+                         int x = 0, int y = 0);
+
+// Write the bounding box of the live cells of `board`. The RLE header holds
+// the rule of the board if it is Life-like.
+void write_rle(std::ostream& out, const AbstractGameBoard& board);
+void write_plaintext(std::ostream& out, const AbstractGameBoard& board,
+                     const std::string& name = "");
+// Write `path` in the format given by its extension. Throws
+// std::runtime_error if the file cannot be written.
+void save_pattern(const std::string& path, const AbstractGameBoard& board);
@@ -0,0 +1,208 @@
+#include "pixel_kernel.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// The 8 pixels of every byte, for one pair of colors
+class ByteToPixels {
+ public:
+  ByteToPixels(uint32_t alive, uint32_t dead) {
+    for (int byte = 0; byte < 256; byte++) {
+      for (int bit = 0; bit < 8; bit++) {
+        table_[byte][bit] = (byte >> bit) & 1 ? alive : dead;
+      }
+    }
+  }
+
+  // Write the pixels of the `count` low bits of `word` to `out`
+  void expand(uint64_t word, int count, uint32_t* out) const {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+      std::memcpy(out + i, table_[(word >> i) & 0xff], 8 * sizeof(uint32_t));
+    }
+    if (i < count) {
+      std::memcpy(out + i, table_[(word >> i) & 0xff],
+                  (count - i) * sizeof(uint32_t));
+    }
+  }
+
+ private:
+  uint32_t table_[256][8];
+};
+
+// render_cells() over any source of packed words: get_word(x, k) is word k
+// of row x, for rows in [0, x_size) and words in [0, words)
+template <typename GetWord>
+void render_words(const GetWord& get_word, int x_size, int y_size, int x0,
+                  int y0, int width, int height, uint32_t* pixels, int pitch,
+                  uint32_t alive, uint32_t dead) {
+  // Rebuilding the table costs less than a single block, so it is not kept
+  const ByteToPixels colors(alive, dead);
+  const int words = (y_size + 63) / 64;
+  // Pixel rows of cells outside of the board along y
+  for (int py = 0; py < height; py++) {
+    if (y0 + py < 0 || y0 + py >= y_size) {
+      std::fill(pixels + size_t(py) * pitch,
+                pixels + size_t(py) * pitch + width, dead);
+    }
+  }
+  const int k_begin = std::max(0, y0) / 64;
+  const int k_end = y0 + height <= 0 ? 0 : std::min(words,
+                                                    (y0 + height + 63) / 64);
+  uint64_t block[64];
+  for (int bx = 0; bx < width; bx += 64) {
+    const int columns = std::min(64, width - bx);
+    for (int k = k_begin; k < k_end; k++) {
+      // Rows x0 + bx + i of word k, transposed into columns
+      for (int i = 0; i < 64; i++) {
+        const int x = x0 + bx + i;
+        block[i] = i < columns && x >= 0 && x < x_size ? get_word(x, k) : 0;
+      }
+      transpose64(block);
+      // block[j] now holds the cells (x0 + bx + i, 64 k + j) at bit i
+      const int j_begin = std::max(0, y0 - 64 * k);
+      const int j_end = std::min(64, y0 + height - 64 * k);
+      for (int j = j_begin; j < j_end; j++) {
+        colors.expand(block[j], columns,
+                      pixels + size_t(64 * k + j - y0) * pitch + bx);
+      }
+    }
+  }
+}
+
+// OR every pair of bits of `word` into one, packed into the low half
+uint64_t merge_pairs(uint64_t word) {
+  word = (word | word >> 1) & 0x5555555555555555UL;
+  word = (word | word >> 1) & 0x3333333333333333UL;
+  word = (word | word >> 2) & 0x0F0F0F0F0F0F0F0FUL;
+  word = (word | word >> 4) & 0x00FF00FF00FF00FFUL;
+  word = (word | word >> 8) & 0x0000FFFF0000FFFFUL;
+  return (word | word >> 16) & 0x00000000FFFFFFFFUL;
+}
+
+// downsample() over any source of packed words, like render_words()
+template <typename GetWord>
+void downsample_words(const GetWord& get_word, int x_size, int y_size,
+                      int x0, int y0, int shift, TwoDimBitMap& out) {
+  const int64_t words = (y_size + 63) / 64;
+  const int64_t block = int64_t(1) << shift;
+  // Window w is the 64 cells from y0 + 64 w on; out bit j covers windows
+  // [j << shift >> 6, (j + 1) << shift >> 6), or a part of one
+  const int out_words = (out.y_size() + 63) / 64;
+  const int64_t windows = int64_t(out_words) << shift;
+  // Only the windows overlapping the board are read
+  const int64_t w_begin = std::min<int64_t>(windows, y0 >= 0 ? 0 : -y0 / 64);
+  const int64_t w_end = std::max<int64_t>(
+      w_begin, std::min<int64_t>(windows, y_size - y0 <= 0
+                                              ? 0
+                                              : (y_size - y0 + 63) / 64));
+  // Window w spans words k0 + w and k0 + w + 1 of a row, from bit offset on
+  const int64_t k0 = y0 >= 0 ? y0 / 64 : -((63 - int64_t(y0)) / 64);
+  const int offset = y0 - 64 * k0;
+  const int64_t k_begin = std::max<int64_t>(0, k0 + w_begin);
+  const int64_t k_end = std::min(words, k0 + w_end + 1);
+  const uint64_t last_mask =
+      out.y_size() % 64 ? (uint64_t(1) << (out.y_size() % 64)) - 1 : ~0UL;
+  // Words k0 + w_begin on of the rows of a block, ORed together. Words off
+  // the board stay zero, as do the padding bits of the last word.
+  std::vector<uint64_t> merged(w_end - w_begin + 1);
+  auto window = [&](int64_t w) -> uint64_t {
+    if (w < w_begin || w >= w_end) {
+      return 0;
+    }
+    const uint64_t low = merged[w - w_begin];
+    return offset ? low >> offset | merged[w - w_begin + 1] << (64 - offset)
+                  : low;
+  };
+  for (int i = 0; i < out.x_size(); i++) {
+    // OR the rows of the block first, reading each of them in order, and
+    // line the result up with the windows after
+    std::fill(merged.begin(), merged.end(), 0);
+    const int x_begin = std::max<int64_t>(0, x0 + i * block);
+    const int x_end = std::min<int64_t>(x_size, x0 + (i + 1) * block);
+    for (int x = x_begin; x < x_end; x++) {
+      for (int64_t k = k_begin; k < k_end; k++) {
+        merged[k - k0 - w_begin] |= get_word(x, k);
+      }
+    }
+    uint64_t* row = out.row(i);
+    for (int k = 0; k < out_words; k++) {
+      uint64_t word = 0;
+      if (shift < 6) {
+        // Every window makes 64 >> shift bits
+        const int bits = 64 >> shift;
+        for (int s = 0; s < block; s++) {
+          uint64_t cells = window(k * block + s);
+          for (int halve = 0; halve < shift; halve++) {
+            cells = merge_pairs(cells);
+          }
+          word |= cells << (s * bits);
+        }
+      } else {
+        // Every bit is one or more whole windows
+        const int64_t per_bit = block / 64;
+        for (int j = 0; j < 64; j++) {
+          const int64_t first = (64 * int64_t(k) + j) * per_bit;
+          const int64_t begin = std::max(first, w_begin);
+          const int64_t end = std::min(first + per_bit, w_end);
+          bool alive = false;
+          for (int64_t w = begin; w < end && !alive; w++) {
+            alive = window(w) != 0;
+          }
+          word |= uint64_t(alive) << j;
+        }
+      }
+      row[k] = k == out_words - 1 ? word & last_mask : word;
+    }
+  }
+}
+
+}  // namespace
+
+void transpose64(uint64_t block[64]) {
+  // Swap the off-diagonal 32x32 blocks, then the 16x16 blocks within each of
+  // them, and so on down to single bits
+  uint64_t mask = 0x00000000FFFFFFFFUL;
+  for (int j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+    for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      uint64_t t = ((block[k] >> j) ^ block[k | j]) & mask;
+      block[k | j] ^= t;
+      block[k] ^= t << j;
+    }
+  }
+}
+
+void render_cells(const AbstractGameBoard& board, int x0, int y0, int width,
+                  int height, uint32_t* pixels, int pitch, uint32_t alive,
+                  uint32_t dead) {
+  render_words([&](int x, int k) { return board.get_word(x, k); },
+               board.get_board_size().first, board.get_board_size().second,
+               x0, y0, width, height, pixels, pitch, alive, dead);
+}
+
+void render_cells(const TwoDimBitMap& cells, int x0, int y0, int width,
+                  int height, uint32_t* pixels, int pitch, uint32_t alive,
+                  uint32_t dead) {
+  render_words([&](int x, int k) { return cells.row(x)[k]; }, cells.x_size(),
+               cells.y_size(), x0, y0, width, height, pixels, pitch, alive,
+               dead);
+}
+
+void downsample(const AbstractGameBoard& board, int x0, int y0, int shift,
+                TwoDimBitMap& out) {
+  const int x_size = board.get_board_size().first;
+  const int y_size = board.get_board_size().second;
+  // The bit map engines skip the virtual call per word
+  const BitMapGameBoard* bitmap = dynamic_cast<const BitMapGameBoard*>(&board);
+  if (bitmap != nullptr) {
+    const TwoDimBitMap& cells = bitmap->cells();
+    downsample_words([&](int x, int k) { return cells.row(x)[k]; }, x_size,
+                     y_size, x0, y0, shift, out);
+  } else {
+    downsample_words([&](int x, int k) { return board.get_word(x, k); },
+                     x_size, y_size, x0, y0, shift, out);
+  }
+}
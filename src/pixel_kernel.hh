@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "game_board.hh"
+
+// Transpose the 64x64 bit matrix whose row i is `block[i]`, so that bit j of
+// block[i] ends up as bit i of block[j]
+void transpose64(uint64_t block[64]);
+
+// Write the cells of `board` in the rectangle starting at cell (x0, y0) as
+// `width` x `height` pixels: pixel (px, py) is cell (x0 + px, y0 + py), i.e.
+// board x runs along the screen rows like in Game::draw_board(). Live cells
+// become `alive`, dead cells and cells outside of the board `dead`.
+// `pixels` holds `height` rows of `pitch` pixels each.
+//
+// The board is read a packed word at a time with get_word(). As words run
+// along y, i.e. down the screen, every 64x64 block of cells is transposed in
+// registers and each byte of the result expands to 8 pixels via a table, so
+// no cell is visited on its own.
+void render_cells(const AbstractGameBoard& board, int x0, int y0, int width,
+                  int height, uint32_t* pixels, int pitch, uint32_t alive,
+                  uint32_t dead);
+// The same for a copy of the cells of a board
+void render_cells(const TwoDimBitMap& cells, int x0, int y0, int width,
+                  int height, uint32_t* pixels, int pitch, uint32_t alive,
+                  uint32_t dead);
+
+// Shrink the region of `board` starting at cell (x0, y0) into `out`, one
+// cell of `out` per block of 2^shift x 2^shift cells: cell (i, j) of `out`
+// is alive if any cell of the block starting at (x0 + (i << shift),
+// y0 + (j << shift)) is. Cells outside of the board are dead. Only the
+// cells of the region are read, a word at a time; with shift 0 this is a
+// plain copy of the region.
+void downsample(const AbstractGameBoard& board, int x0, int y0, int shift,
+                TwoDimBitMap& out);
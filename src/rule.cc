@@ -0,0 +1,250 @@
+#include "rule.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+
+// Limits of the multi-state rules: the cells are stored in one byte, and the
+// neighbourhood must stay reasonably small
+constexpr int kMaxStates = 256;
+constexpr int kMaxRadius = 100;
+
+// Parse a non-negative decimal number that makes up all of `str`
+int parse_number(const std::string& str, const std::string& rule) {
+  if (str.empty() || str.size() > 6 ||
+      str.find_first_not_of("0123456789") != std::string::npos) {
+    throw std::invalid_argument("Invalid rule \"" + rule + "\": \"" + str +
+                                "\" is not a number");
+  }
+  return std::stoi(str);
+}
+
+}  // namespace
+
+Rule::Rule(uint16_t birth, uint16_t survival)
+    : birth_(birth), survival_(survival) {
+  // A cell has at most 8 neighbours
+  if ((birth | survival) >> 9) {
+    throw std::invalid_argument("A rule can only count up to 8 neighbours");
+  }
+}
+
+Rule Rule::parse(const std::string& rule) {
+  auto fail = [&rule](const std::string& why) {
+    return std::invalid_argument("Invalid rule \"" + rule + "\": " + why);
+  };
+  size_t slash = rule.find('/');
+  if (slash == std::string::npos) {
+    throw fail("expected B<digits>/S<digits>");
+  }
+  uint16_t masks[2] = {0, 0};  // Birth and survival
+  bool seen[2] = {false, false};
+  for (const std::string& part :
+       {rule.substr(0, slash), rule.substr(slash + 1)}) {
+    if (part.empty()) {
+      throw fail("expected B<digits>/S<digits>");
+    }
+    char letter = std::toupper(static_cast<unsigned char>(part[0]));
+    if (letter != 'B' && letter != 'S') {
+      throw fail("each part must start with B or S");
+    }
+    int which = letter == 'B' ? 0 : 1;
+    if (seen[which]) {
+      throw fail(std::string("duplicate ") + letter);
+    }
+    seen[which] = true;
+    for (size_t i = 1; i < part.size(); i++) {
+      if (part[i] < '0' || part[i] > '8') {
+        throw fail("neighbour counts must be digits from 0 to 8");
+      }
+      masks[which] |= 1 << (part[i] - '0');
+    }
+  }
+  return Rule(masks[0], masks[1]);
+}
+
+std::string Rule::to_string() const {
+  std::string str = "B";
+  for (int n = 0; n <= 8; n++) {
+    if ((birth_ >> n) & 1) {
+      str += static_cast<char>('0' + n);
+    }
+  }
+  str += "/S";
+  for (int n = 0; n <= 8; n++) {
+    if ((survival_ >> n) & 1) {
+      str += static_cast<char>('0' + n);
+    }
+  }
+  return str;
+}
+
+// ---------------------------------------------------------------------------
+//                             MultiStateRule
+// ---------------------------------------------------------------------------
+
+MultiStateRule::MultiStateRule(int radius, int states, bool counts_center)
+    : radius_(radius), states_(states), counts_center_(counts_center) {
+  birth_.resize(max_count() + 1);
+  survival_.resize(max_count() + 1);
+}
+
+MultiStateRule::MultiStateRule(const Rule& rule) : MultiStateRule(1, 2, false) {
+  for (int n = 0; n <= 8; n++) {
+    birth_[n] = (rule.birth() >> n) & 1;
+    survival_[n] = (rule.survival() >> n) & 1;
+  }
+}
+
+MultiStateRule MultiStateRule::parse(const std::string& rule) {
+  auto fail = [&rule](const std::string& why) {
+    return std::invalid_argument("Invalid rule \"" + rule + "\": " + why);
+  };
+
+  if (rule.find(',') == std::string::npos) {
+    // Generations: B/S with an optional /C part
+    size_t c = rule.find_first_of("Cc");
+    if (c == std::string::npos) {
+      return MultiStateRule(Rule::parse(rule));
+    }
+    if (c == 0 || rule[c - 1] != '/') {
+      throw fail("the number of states must be a separate /C part");
+    }
+    size_t end = rule.find('/', c);
+    int states = parse_number(rule.substr(c + 1, end - c - 1), rule);
+    if (states < 2 || states > kMaxStates) {
+      throw fail("the number of states must be between 2 and " +
+                 std::to_string(kMaxStates));
+    }
+    std::string life_like = rule.substr(0, c - 1);
+    if (end != std::string::npos) {
+      life_like += rule.substr(end);
+    }
+    MultiStateRule result(Rule::parse(life_like));
+    result.states_ = states;
+    return result;
+  }
+
+  // Larger than Life: comma separated R, C, M, S, B and N parts
+  int radius = -1, states = 2;
+  bool counts_center = false;
+  int ranges[2][2] = {{-1, -1}, {-1, -1}};  // Survival and birth
+  size_t begin = 0;
+  while (begin <= rule.size()) {
+    size_t end = std::min(rule.find(',', begin), rule.size());
+    std::string part = rule.substr(begin, end - begin);
+    begin = end + 1;
+    if (part.empty()) {
+      throw fail("empty part");
+    }
+    std::string value = part.substr(1);
+    switch (std::toupper(static_cast<unsigned char>(part[0]))) {
+      case 'R':
+        radius = parse_number(value, rule);
+        break;
+      case 'C':
+        // C0 and C1 are the same as C2
+        states = std::max(parse_number(value, rule), 2);
+        break;
+      case 'M':
+        if (value != "0" && value != "1") {
+          throw fail("M must be 0 or 1");
+        }
+        counts_center = value == "1";
+        break;
+      case 'S':
+      case 'B': {
+        size_t dots = value.find("..");
+        if (dots == std::string::npos) {
+          throw fail("expected a range min..max");
+        }
+        int* range = ranges[std::toupper(part[0]) == 'B'];
+        range[0] = parse_number(value.substr(0, dots), rule);
+        range[1] = parse_number(value.substr(dots + 2), rule);
+        if (range[0] > range[1]) {
+          throw fail("empty range " + value);
+        }
+        break;
+      }
+      case 'N':
+        if (std::toupper(static_cast<unsigned char>(value[0])) != 'M' ||
+            value.size() != 1) {
+          throw fail("only the Moore neighbourhood (NM) is supported");
+        }
+        break;
+      default:
+        throw fail("unknown part " + part);
+    }
+  }
+  if (radius < 1 || radius > kMaxRadius) {
+    throw fail("the radius must be between 1 and " +
+               std::to_string(kMaxRadius));
+  }
+  if (states > kMaxStates) {
+    throw fail("there can be at most " + std::to_string(kMaxStates) +
+               " states");
+  }
+  if (ranges[0][0] < 0 || ranges[1][0] < 0) {
+    throw fail("both the S and the B range are required");
+  }
+  MultiStateRule result(radius, states, counts_center);
+  if (ranges[0][1] > result.max_count() || ranges[1][1] > result.max_count()) {
+    throw fail("a range goes past the largest count " +
+               std::to_string(result.max_count()));
+  }
+  for (int n = ranges[0][0]; n <= ranges[0][1]; n++) {
+    result.survival_[n] = true;
+  }
+  for (int n = ranges[1][0]; n <= ranges[1][1]; n++) {
+    result.birth_[n] = true;
+  }
+  return result;
+}
+
+bool MultiStateRule::is_life_like() const {
+  return states_ == 2 && radius_ == 1 && !counts_center_;
+}
+
+Rule MultiStateRule::to_life_like() const {
+  if (!is_life_like()) {
+    throw std::logic_error(to_string() + " is not a Life-like rule");
+  }
+  uint16_t birth = 0, survival = 0;
+  for (int n = 0; n <= 8; n++) {
+    birth |= birth_[n] << n;
+    survival |= survival_[n] << n;
+  }
+  return Rule(birth, survival);
+}
+
+std::string MultiStateRule::to_string() const {
+  if (radius_ == 1 && !counts_center_) {
+    MultiStateRule life_like = *this;
+    life_like.states_ = 2;
+    std::string str = life_like.to_life_like().to_string();
+    if (states_ > 2) {
+      str += "/C" + std::to_string(states_);
+    }
+    return str;
+  }
+  // The sets are single ranges, as Larger than Life rules can only be
+  // written with ranges
+  auto range = [](const std::vector<bool>& set) {
+    int first = 0, last = static_cast<int>(set.size()) - 1;
+    while (first < last && !set[first]) first++;
+    while (last > first && !set[last]) last--;
+    return std::to_string(first) + ".." + std::to_string(last);
+  };
+  return "R" + std::to_string(radius_) + ",C" +
+         std::to_string(states_ == 2 ? 0 : states_) + ",M" +
+         (counts_center_ ? "1" : "0") + ",S" + range(survival_) + ",B" +
+         range(birth_) + ",NM";
+}
+
+bool MultiStateRule::operator==(const MultiStateRule& other) const {
+  return radius_ == other.radius_ && states_ == other.states_ &&
+         counts_center_ == other.counts_center_ && birth_ == other.birth_ &&
+         survival_ == other.survival_;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A rule whose masks are compile-time constants. Kernels instantiated for a
+// StaticRule fold the rule into the code, so they pay nothing for it at
+// runtime.
+template <uint16_t Birth, uint16_t Survival>
+struct StaticRule {
+  static constexpr uint16_t birth() { return Birth; }
+  static constexpr uint16_t survival() { return Survival; }
+};
+
+/**
+ * A Life-like rule.
+ *
+ * Bit n of the birth mask is set if a dead cell with n live neighbours is
+ * born, bit n of the survival mask is set if a live cell with n live
+ * neighbours stays alive. Rules are written in B/S notation, e.g. "B3/S23"
+ * for Conway's Game of Life or "B36/S23" for HighLife.
+ * */
+class Rule {
+ public:
+  // Conway's Game of Life, B3/S23
+  Rule() : Rule(1 << 3, 1 << 2 | 1 << 3) {}
+  Rule(uint16_t birth, uint16_t survival);
+  template <uint16_t Birth, uint16_t Survival>
+  explicit Rule(StaticRule<Birth, Survival>) : Rule(Birth, Survival) {}
+
+  // Parse a rule in B/S notation, e.g. "B3/S23". The letters are case
+  // insensitive and the two parts may come in either order. Throws
+  // std::invalid_argument if `rule` is malformed.
+  static Rule parse(const std::string& rule);
+
+  uint16_t birth() const { return birth_; }
+  uint16_t survival() const { return survival_; }
+  // Whether dead cells without any live neighbour are born, which rules out
+  // engines that treat empty space as dead forever
+  bool births_from_nothing() const { return birth_ & 1; }
+
+  bool next_state(bool alive, int live_neighbors) const {
+    return ((alive ? survival_ : birth_) >> live_neighbors) & 1;
+  }
+
+  // The rule in B/S notation
+  std::string to_string() const;
+
+  bool operator==(const Rule& other) const {
+    return birth_ == other.birth_ && survival_ == other.survival_;
+  }
+  bool operator!=(const Rule& other) const { return !(*this == other); }
+
+ private:
+  uint16_t birth_;
+  uint16_t survival_;
+};
+
+// The rules with specialized kernels
+typedef StaticRule<1 << 3, 1 << 2 | 1 << 3> LifeRule;             // B3/S23
+typedef StaticRule<1 << 3 | 1 << 6, 1 << 2 | 1 << 3> HighLifeRule;  // B36/S23
+typedef StaticRule<1 << 3 | 1 << 6 | 1 << 7 | 1 << 8,
+                   1 << 3 | 1 << 4 | 1 << 6 | 1 << 7 | 1 << 8>
+    DayAndNightRule;                       // B3678/S34678
+typedef StaticRule<1 << 2, 0> SeedsRule;  // B2/S
+
+// Call `f` with the StaticRule equal to `rule` if it is one of the rules
+// above, otherwise with `rule` itself. `f` is usually a generic lambda, so
+// the hot rules get their own instantiation of it.
+template <typename F>
+void dispatch_rule(const Rule& rule, F&& f) {
+  if (rule == Rule(LifeRule())) {
+    f(LifeRule());
+  } else if (rule == Rule(HighLifeRule())) {
+    f(HighLifeRule());
+  } else if (rule == Rule(DayAndNightRule())) {
+    f(DayAndNightRule());
+  } else if (rule == Rule(SeedsRule())) {
+    f(SeedsRule());
+  } else {
+    f(rule);
+  }
+}
+
+/**
+ * A multi-state rule: Generations rules, where a cell that dies decays
+ * through `states() - 2` dying states before it is dead, and Larger than
+ * Life rules, which count the live cells in a (2R+1) x (2R+1) square.
+ *
+ * State 0 is dead and state 1 is alive; only alive cells count as
+ * neighbours. A dead cell with a neighbour count in the birth set becomes
+ * alive. An alive cell with a count in the survival set stays alive,
+ * otherwise it starts decaying (or dies if there are only two states). A
+ * dying cell always moves on to the next state, and the state after the
+ * last one is dead.
+ *
+ * Rules are written in Generations notation, e.g. "B2/S/C3" for Brian's
+ * Brain (a Life-like rule has 2 states), or in Golly's Larger than Life
+ * notation, e.g. "R5,C0,M1,S34..58,B34..45,NM" for Bosco's Rule. M1 counts
+ * the cell itself as its own neighbour.
+ * */
+class MultiStateRule {
+ public:
+  // The Life-like rule, two states and radius 1
+  MultiStateRule(const Rule& rule = Rule());
+
+  // Parse a rule in either notation. Throws std::invalid_argument if `rule`
+  // is malformed.
+  static MultiStateRule parse(const std::string& rule);
+
+  int radius() const { return radius_; }
+  int states() const { return states_; }
+  bool counts_center() const { return counts_center_; }
+  // Largest possible neighbour count
+  int max_count() const {
+    return (2 * radius_ + 1) * (2 * radius_ + 1) - !counts_center_;
+  }
+  bool births(int count) const { return birth_[count]; }
+  bool survives(int count) const { return survival_[count]; }
+
+  // Whether the rule is a Life-like rule: two states, radius 1, and the cell
+  // itself not counted
+  bool is_life_like() const;
+  // The rule as a Life-like rule. Throws std::logic_error if it is not one.
+  Rule to_life_like() const;
+
+  // The rule in Generations notation if the radius is 1 and the cell itself
+  // is not counted, in Larger than Life notation otherwise
+  std::string to_string() const;
+
+  bool operator==(const MultiStateRule& other) const;
+  bool operator!=(const MultiStateRule& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  MultiStateRule(int radius, int states, bool counts_center);
+
+  int radius_;
+  int states_;
+  bool counts_center_;
+  std::vector<bool> birth_;     // Indexed by the neighbour count
+  std::vector<bool> survival_;  // Indexed by the neighbour count
+};
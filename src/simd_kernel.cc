@@ -0,0 +1,223 @@
+#include "simd_kernel.hh"
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "life_kernel.hh"
+
+// GCC vector types; with the target attributes below the bitwise operators
+// on them compile to AVX2 / AVX-512 instructions.
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+typedef uint64_t u64x8 __attribute__((vector_size(64)));
+
+namespace {
+
+// Number of 64-bit lanes in the word type W
+template <typename W>
+constexpr int lanes() {
+  return sizeof(W) / sizeof(uint64_t);
+}
+
+template <typename W>
+LIFE_KERNEL_INLINE void load(W& out, const uint64_t* p) {
+  __builtin_memcpy(&out, p, sizeof(W));
+}
+
+template <typename W>
+LIFE_KERNEL_INLINE void store(uint64_t* p, const W& in) {
+  __builtin_memcpy(p, &in, sizeof(W));
+}
+
+// The rule a kernel instantiated for `R` runs: `R` itself for the rules
+// with compile-time masks, the `rule` passed at runtime otherwise
+template <typename R>
+LIFE_KERNEL_INLINE R kernel_rule(const Rule&) {
+  return R();
+}
+
+template <>
+LIFE_KERNEL_INLINE Rule kernel_rule<Rule>(const Rule& rule) {
+  return rule;
+}
+
+// Scalar kernel for the words in [begin, end)
+template <typename R>
+LIFE_KERNEL_INLINE void scalar_words(uint64_t* out, const uint64_t* up,
+                                     const uint64_t* mid, const uint64_t* down,
+                                     int begin, int end, const R& rule) {
+  for (int k = begin; k < end; k++) {
+    rule_kernel(out[k], rule, up[k - 1], up[k], up[k + 1], mid[k - 1], mid[k],
+                mid[k + 1], down[k - 1], down[k], down[k + 1]);
+  }
+}
+
+// Process the row lanes<W>() words at a time. The unaligned loads at k - 1
+// and k + 1 reach at most into the ghost words around the row; the tail that
+// does not fill a whole vector is handled by the scalar kernel.
+template <typename W, typename R>
+LIFE_KERNEL_INLINE void vector_row(uint64_t* out, const uint64_t* up,
+                                   const uint64_t* mid, const uint64_t* down,
+                                   int words, const R& rule) {
+  const int n = lanes<W>();
+  int k = 0;
+  for (; k + n <= words; k += n) {
+    W up_prev, up_cur, up_next, mid_prev, mid_cur, mid_next, down_prev,
+        down_cur, down_next, res;
+    load(up_prev, up + k - 1);
+    load(up_cur, up + k);
+    load(up_next, up + k + 1);
+    load(mid_prev, mid + k - 1);
+    load(mid_cur, mid + k);
+    load(mid_next, mid + k + 1);
+    load(down_prev, down + k - 1);
+    load(down_cur, down + k);
+    load(down_next, down + k + 1);
+    rule_kernel(res, rule, up_prev, up_cur, up_next, mid_prev, mid_cur,
+                mid_next, down_prev, down_cur, down_next);
+    store(out + k, res);
+  }
+  scalar_words(out, up, mid, down, k, words, rule);
+}
+
+template <typename R>
+void scalar_row(uint64_t* out, const uint64_t* up, const uint64_t* mid,
+                const uint64_t* down, int words, const Rule& rule) {
+  scalar_words(out, up, mid, down, 0, words, kernel_rule<R>(rule));
+}
+
+template <typename R>
+__attribute__((target("avx2"))) void avx2_row(uint64_t* out,
+                                              const uint64_t* up,
+                                              const uint64_t* mid,
+                                              const uint64_t* down, int words,
+                                              const Rule& rule) {
+  vector_row<u64x4>(out, up, mid, down, words, kernel_rule<R>(rule));
+}
+
+template <typename R>
+__attribute__((target("avx512f"))) void avx512_row(uint64_t* out,
+                                                  const uint64_t* up,
+                                                  const uint64_t* mid,
+                                                  const uint64_t* down,
+                                                  int words,
+                                                  const Rule& rule) {
+  vector_row<u64x8>(out, up, mid, down, words, kernel_rule<R>(rule));
+}
+
+// The same loops twice: the attribute lets GCC emit POPCNT for the builtin
+// instead of a call into libgcc. Four sums hide the latency of POPCNT.
+LIFE_KERNEL_INLINE uint64_t popcount_loop(const uint64_t* words, int n) {
+  uint64_t sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    sum0 += __builtin_popcountll(words[i]);
+    sum1 += __builtin_popcountll(words[i + 1]);
+    sum2 += __builtin_popcountll(words[i + 2]);
+    sum3 += __builtin_popcountll(words[i + 3]);
+  }
+  for (; i < n; i++) {
+    sum0 += __builtin_popcountll(words[i]);
+  }
+  return sum0 + sum1 + sum2 + sum3;
+}
+
+LIFE_KERNEL_INLINE void popcount_add_loop(const uint64_t* words, int n,
+                                          uint32_t* counts) {
+  for (int i = 0; i < n; i++) {
+    counts[i] += __builtin_popcountll(words[i]);
+  }
+}
+
+uint64_t popcount_generic(const uint64_t* words, int n) {
+  return popcount_loop(words, n);
+}
+
+__attribute__((target("popcnt"))) uint64_t popcount_hardware(
+    const uint64_t* words, int n) {
+  return popcount_loop(words, n);
+}
+
+void popcount_add_generic(const uint64_t* words, int n, uint32_t* counts) {
+  popcount_add_loop(words, n, counts);
+}
+
+__attribute__((target("popcnt"))) void popcount_add_hardware(
+    const uint64_t* words, int n, uint32_t* counts) {
+  popcount_add_loop(words, n, counts);
+}
+
+bool has_popcnt() {
+  static const bool supported = __builtin_cpu_supports("popcnt");
+  return supported;
+}
+
+}  // namespace
+
+uint64_t popcount_words(const uint64_t* words, int n) {
+  return has_popcnt() ? popcount_hardware(words, n)
+                      : popcount_generic(words, n);
+}
+
+void popcount_add(const uint64_t* words, int n, uint32_t* counts) {
+  if (has_popcnt()) {
+    popcount_add_hardware(words, n, counts);
+  } else {
+    popcount_add_generic(words, n, counts);
+  }
+}
+
+bool simd_isa_supported(SimdIsa isa) {
+  switch (isa) {
+    case SimdIsa::kScalar:
+      return true;
+    case SimdIsa::kAvx2:
+      return __builtin_cpu_supports("avx2");
+    case SimdIsa::kAvx512:
+      return __builtin_cpu_supports("avx512f");
+  }
+  return false;
+}
+
+SimdIsa best_simd_isa() {
+  if (simd_isa_supported(SimdIsa::kAvx512)) {
+    return SimdIsa::kAvx512;
+  }
+  if (simd_isa_supported(SimdIsa::kAvx2)) {
+    return SimdIsa::kAvx2;
+  }
+  return SimdIsa::kScalar;
+}
+
+RowKernel get_row_kernel(SimdIsa isa, const Rule& rule) {
+  if (!simd_isa_supported(isa)) {
+    throw std::runtime_error(std::string(simd_isa_name(isa)) +
+                             " is not supported by this CPU");
+  }
+  RowKernel kernel = nullptr;
+  dispatch_rule(rule, [&](const auto& r) {
+    typedef std::decay_t<decltype(r)> R;
+    switch (isa) {
+      case SimdIsa::kAvx2:
+        kernel = avx2_row<R>;
+        break;
+      case SimdIsa::kAvx512:
+        kernel = avx512_row<R>;
+        break;
+      default:
+        kernel = scalar_row<R>;
+    }
+  });
+  return kernel;
+}
+
+const char* simd_isa_name(SimdIsa isa) {
+  switch (isa) {
+    case SimdIsa::kAvx2:
+      return "AVX2";
+    case SimdIsa::kAvx512:
+      return "AVX-512";
+    default:
+      return "scalar";
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "rule.hh"
+
+// Instruction sets the SIMD row kernel can be compiled for
+enum class SimdIsa { kScalar, kAvx2, kAvx512 };
+
+// Compute the next state of one row of packed cells under `rule`. `up`,
+// `mid` and `down` point to the `words` words of the row above, the row
+// itself and the row below; the result is written to `out`. Like the rows of
+// TwoDimBitMap, the input rows must have a readable ghost word at [-1] and at
+// [words].
+typedef void (*RowKernel)(uint64_t* out, const uint64_t* up,
+                          const uint64_t* mid, const uint64_t* down, int words,
+                          const Rule& rule);
+
+// The widest instruction set supported by the running CPU
+SimdIsa best_simd_isa();
+
+// Whether the running CPU can execute kernels compiled for `isa`
+bool simd_isa_supported(SimdIsa isa);
+
+// Get the row kernel for `isa`, which must be supported by the running CPU.
+// The hot rules (see dispatch_rule) get a kernel specialized for them, which
+// ignores the `rule` passed to it; other rules get a generic kernel.
+RowKernel get_row_kernel(SimdIsa isa, const Rule& rule);
+
+const char* simd_isa_name(SimdIsa isa);
+
+// Number of set bits in the `n` words at `words`, with the POPCNT
+// instruction if the running CPU has it
+uint64_t popcount_words(const uint64_t* words, int n);
+// Add the number of set bits of words[k] to counts[k] for k in [0, n)
+void popcount_add(const uint64_t* words, int n, uint32_t* counts);
@@ -0,0 +1,338 @@
+#include "snapshot.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+const char kMagic[8] = "GOLSNAP";
+
+std::runtime_error system_error(const std::string& what,
+                                const std::string& path) {
+  return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// Tiles of a board: 64 rows by one word
+int tiles_x(int x_size) { return (x_size + 63) / 64; }
+int tiles_y(int y_size) { return (y_size + 63) / 64; }
+// Words of the bit per tile telling whether it is stored
+size_t tile_mask_words(int x_size, int y_size) {
+  return (size_t(tiles_x(x_size)) * tiles_y(y_size) + 63) / 64;
+}
+
+// Write all of `iov` to `fd`, resuming after short writes
+void write_all(int fd, std::vector<iovec> iov, const std::string& path) {
+  size_t i = 0;
+  while (i < iov.size()) {
+    ssize_t written = writev(fd, &iov[i], std::min<size_t>(iov.size() - i,
+                                                           IOV_MAX));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw system_error("Cannot write", path);
+    }
+    while (i < iov.size() && size_t(written) >= iov[i].iov_len) {
+      written -= iov[i++].iov_len;
+    }
+    if (i < iov.size()) {
+      iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + written;
+      iov[i].iov_len -= written;
+    }
+  }
+}
+
+// Write the header and `words` to `path` through a temporary file
+void write_snapshot(const std::string& path, const SnapshotHeader& header,
+                    const uint64_t* words, size_t size) {
+  static const char padding[kSnapshotDataOffset] = {};
+  const std::string temporary = path + ".tmp";
+  int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw system_error("Cannot create", temporary);
+  }
+  try {
+    write_all(fd,
+              {{const_cast<SnapshotHeader*>(&header), sizeof(header)},
+               {const_cast<char*>(padding), sizeof(padding) - sizeof(header)},
+               {const_cast<uint64_t*>(words), size * sizeof(uint64_t)}},
+              temporary);
+    if (fdatasync(fd) != 0) {
+      throw system_error("Cannot sync", temporary);
+    }
+  } catch (...) {
+    close(fd);
+    std::remove(temporary.c_str());
+    throw;
+  }
+  close(fd);
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    throw system_error("Cannot rename to", path);
+  }
+}
+
+// Throw unless `header` describes a snapshot of `file_size` bytes
+void check_header(const SnapshotHeader& header, uint64_t file_size,
+                  const std::string& path) {
+  auto invalid = [&](const std::string& why) {
+    return std::runtime_error(path + " is not a valid snapshot: " + why);
+  };
+  if (file_size < sizeof(header) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw invalid("bad magic");
+  }
+  if (header.version != kSnapshotVersion) {
+    throw invalid("version " + std::to_string(header.version));
+  }
+  if (header.x_size <= 0 || header.y_size <= 0 ||
+      header.flags & ~kSnapshotTiles) {
+    throw invalid("bad size or flags");
+  }
+  const bool tiles = header.flags & kSnapshotTiles;
+  if (!tiles && header.row_stride !=
+                    TwoDimBitMap::row_stride_for(header.y_size)) {
+    throw invalid("unexpected row stride");
+  }
+  // A raw snapshot holds exactly the storage of a map, a tiled one at least
+  // the tile mask
+  const uint64_t raw_words =
+      TwoDimBitMap::storage_words_for(header.x_size, header.y_size);
+  const uint64_t mask_words = tile_mask_words(header.x_size, header.y_size);
+  if (header.data_offset != kSnapshotDataOffset ||
+      file_size < header.data_offset ||
+      header.data_words >
+          (file_size - header.data_offset) / sizeof(uint64_t) ||
+      (tiles ? header.data_words < mask_words
+             : header.data_words != raw_words)) {
+    throw invalid("truncated");
+  }
+}
+
+SnapshotInfo info_of(const SnapshotHeader& header) {
+  SnapshotInfo info;
+  info.x_size = header.x_size;
+  info.y_size = header.y_size;
+  info.rule = Rule(header.birth, header.survival);
+  info.generation = header.generation;
+  info.tiles = header.flags & kSnapshotTiles;
+  return info;
+}
+
+// A whole file mapped copy-on-write, unmapped with the last reference
+struct Mapping {
+  std::shared_ptr<void> memory;
+  uint64_t size = 0;
+};
+
+Mapping map_file(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw system_error("Cannot open", path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    throw std::runtime_error(path + " is not a valid snapshot: empty");
+  }
+  const uint64_t size = st.st_size;
+  void* memory =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    throw system_error("Cannot map", path);
+  }
+  Mapping mapping;
+  mapping.memory.reset(memory, [size](void* p) { munmap(p, size); });
+  mapping.size = size;
+  return mapping;
+}
+
+// Write the tiles of `header` at `words` to `cells`
+void decode_tiles(const SnapshotHeader& header, const uint64_t* words,
+                  TwoDimBitMap& cells, const std::string& path) {
+  const int ty_count = tiles_y(header.y_size);
+  const uint64_t* mask = words;
+  const uint64_t* tile = words + tile_mask_words(header.x_size, header.y_size);
+  const uint64_t* end = words + header.data_words;
+  for (int tx = 0; tx < tiles_x(header.x_size); tx++) {
+    for (int ty = 0; ty < ty_count; ty++) {
+      const size_t t = size_t(tx) * ty_count + ty;
+      if (!(mask[t / 64] >> (t % 64) & 1)) {
+        continue;
+      }
+      if (end - tile < 64) {
+        throw std::runtime_error(path + " is not a valid snapshot: "
+                                 "truncated tiles");
+      }
+      for (int r = 0; r < 64 && tx * 64 + r < header.x_size; r++) {
+        cells.row(tx * 64 + r)[ty] = tile[r];
+      }
+      tile += 64;
+    }
+  }
+  // Rows must not have cells past the end
+  if (header.y_size % 64) {
+    const uint64_t last = (1UL << (header.y_size % 64)) - 1;
+    for (int x = 0; x < header.x_size; x++) {
+      cells.row(x)[ty_count - 1] &= last;
+    }
+  }
+}
+
+}  // namespace
+
+void copy_cells(const AbstractGameBoard& board, TwoDimBitMap& cells) {
+  const BitMapGameBoard* bitmap =
+      dynamic_cast<const BitMapGameBoard*>(&board);
+  if (bitmap) {
+    std::memcpy(cells.storage(), bitmap->cells().storage(),
+                cells.storage_words() * sizeof(uint64_t));
+    return;
+  }
+  for (int x = 0; x < cells.x_size(); x++) {
+    for (int k = 0; k < cells.words_per_row(); k++) {
+      cells.row(x)[k] = board.get_word(x, k);
+    }
+  }
+}
+
+void save_snapshot(const std::string& path, const AbstractGameBoard& board,
+                   uint64_t generation, bool tiles) {
+  Rule rule;
+  try {
+    rule = board.get_rule();
+  } catch (const std::logic_error&) {
+    throw std::invalid_argument("Snapshots only hold Life-like boards");
+  }
+  // The cells as they are in a BitMapGameBoard, gathered for other boards
+  const BitMapGameBoard* bitmap =
+      dynamic_cast<const BitMapGameBoard*>(&board);
+  if (bitmap) {
+    save_snapshot(path, bitmap->cells(), rule, generation, tiles);
+    return;
+  }
+  TwoDimBitMap gathered(board.get_board_size().first,
+                        board.get_board_size().second);
+  copy_cells(board, gathered);
+  save_snapshot(path, gathered, rule, generation, tiles);
+}
+
+void save_snapshot(const std::string& path, const TwoDimBitMap& cells,
+                   const Rule& rule, uint64_t generation, bool tiles) {
+  SnapshotHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kSnapshotVersion;
+  header.flags = tiles ? kSnapshotTiles : 0;
+  header.x_size = cells.x_size();
+  header.y_size = cells.y_size();
+  header.row_stride = cells.row_stride();
+  header.birth = rule.birth();
+  header.survival = rule.survival();
+  header.generation = generation;
+  header.data_offset = kSnapshotDataOffset;
+
+  if (!tiles) {
+    header.data_words = cells.storage_words();
+    write_snapshot(path, header, cells.storage(), header.data_words);
+    return;
+  }
+  const int ty_count = tiles_y(header.y_size);
+  std::vector<uint64_t> words(
+      tile_mask_words(header.x_size, header.y_size));
+  for (int tx = 0; tx < tiles_x(header.x_size); tx++) {
+    const int rows = std::min(64, header.x_size - tx * 64);
+    for (int ty = 0; ty < ty_count; ty++) {
+      uint64_t any = 0;
+      for (int r = 0; r < rows; r++) {
+        any |= cells.row(tx * 64 + r)[ty];
+      }
+      if (!any) {
+        continue;
+      }
+      const size_t t = size_t(tx) * ty_count + ty;
+      words[t / 64] |= 1UL << (t % 64);
+      for (int r = 0; r < 64; r++) {
+        words.push_back(r < rows ? cells.row(tx * 64 + r)[ty] : 0);
+      }
+    }
+  }
+  header.data_words = words.size();
+  write_snapshot(path, header, words.data(), words.size());
+}
+
+SnapshotInfo read_snapshot_info(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw system_error("Cannot open", path);
+  }
+  SnapshotHeader header{};
+  struct stat st;
+  ssize_t bytes = pread(fd, &header, sizeof(header), 0);
+  int status = fstat(fd, &st);
+  close(fd);
+  if (bytes < 0 || status != 0) {
+    throw system_error("Cannot read", path);
+  }
+  check_header(header, bytes < ssize_t(sizeof(header)) ? 0 : st.st_size,
+               path);
+  return info_of(header);
+}
+
+SnapshotInfo load_snapshot(const std::string& path,
+                           AbstractGameBoard& board) {
+  Mapping mapping = map_file(path);
+  SnapshotHeader header{};
+  if (mapping.size < sizeof(header)) {
+    check_header(header, 0, path);  // Throws
+  }
+  std::memcpy(&header, mapping.memory.get(), sizeof(header));
+  check_header(header, mapping.size, path);
+  if (board.get_board_size() != std::make_pair(header.x_size,
+                                               header.y_size)) {
+    throw std::invalid_argument(
+        "The snapshot is " + std::to_string(header.x_size) + "x" +
+        std::to_string(header.y_size) + ", the board is not");
+  }
+  uint64_t* words = reinterpret_cast<uint64_t*>(
+      static_cast<char*>(mapping.memory.get()) + header.data_offset);
+
+  BitMapGameBoard* bitmap = dynamic_cast<BitMapGameBoard*>(&board);
+  if (header.flags & kSnapshotTiles) {
+    TwoDimBitMap cells(header.x_size, header.y_size);
+    decode_tiles(header, words, cells, path);
+    if (bitmap) {
+      bitmap->adopt_cells(std::move(cells));
+      return info_of(header);
+    }
+    board.clear();
+    for (int x = 0; x < header.x_size; x++) {
+      for (int k = 0; k < cells.words_per_row(); k++) {
+        board.set_word(x, k, cells.row(x)[k]);
+      }
+    }
+    return info_of(header);
+  }
+
+  TwoDimBitMap cells(header.x_size, header.y_size, words, mapping.memory);
+  if (bitmap) {
+    bitmap->adopt_cells(std::move(cells));
+  } else {
+    board.clear();
+    for (int x = 0; x < header.x_size; x++) {
+      for (int k = 0; k < cells.words_per_row(); k++) {
+        board.set_word(x, k, cells.row(x)[k]);
+      }
+    }
+  }
+  return info_of(header);
+}
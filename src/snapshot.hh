@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "game_board.hh"
+
+/**
+ * Binary snapshots of a board for checkpoint and restore.
+ *
+ * A snapshot is a 64-byte header, zero padding up to kSnapshotDataOffset and
+ * the cells in one of two layouts:
+ *   - raw: the storage of a TwoDimBitMap of the board size as it is in
+ *     memory, ghost cells and padding included. Rows start on cache lines
+ *     and the data starts on a page, so the file can be mapped and used as
+ *     the current generation of a BitMapGameBoard without copying it.
+ *   - tiles: a bit per 64x64 tile (64 rows of one packed word, indexed
+ *     like BitMapGameBoard::tile_population()) telling whether it has live
+ *     cells, then the 64 words of every such tile. Empty space is dropped,
+ *     which suits sparse boards, but the file has to be decoded.
+ * Words are little-endian, as in memory.
+ *
+ * Both layouts are written with a single writev() straight from the board
+ * to a temporary file that is renamed over the target once it is on disk,
+ * so a crash never leaves a half-written snapshot behind.
+ * */
+
+// Where the cells start in a snapshot file: one page, so mapping the file
+// keeps the cache line alignment of the rows
+constexpr uint64_t kSnapshotDataOffset = 4096;
+
+struct SnapshotHeader {
+  char magic[8];        // "GOLSNAP\0"
+  uint32_t version;     // kSnapshotVersion
+  uint32_t flags;       // kSnapshotTiles or 0 for the raw layout
+  int32_t x_size, y_size;
+  int32_t row_stride;   // Words between two rows of the raw layout
+  uint16_t birth, survival;  // The rule, see Rule
+  uint64_t generation;  // Generations simulated before the snapshot
+  uint64_t data_offset;  // kSnapshotDataOffset
+  uint64_t data_words;   // Words of cells at `data_offset`
+  uint64_t reserved;
+};
+static_assert(sizeof(SnapshotHeader) == 64, "The header is one cache line");
+
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr uint32_t kSnapshotTiles = 1;
+
+// What a snapshot holds, apart from the cells
+struct SnapshotInfo {
+  int x_size = 0, y_size = 0;
+  Rule rule;
+  uint64_t generation = 0;
+  bool tiles = false;  // Whether the cells are stored as tiles
+};
+
+// Write the cells of `board` after `generation` generations to `path`,
+// as tiles if `tiles` is set. Boards other than BitMapGameBoard are
+// gathered a word at a time first. Throws std::invalid_argument for boards
+// whose rule is not Life-like and std::runtime_error if writing fails.
+void save_snapshot(const std::string& path, const AbstractGameBoard& board,
+                   uint64_t generation, bool tiles = false);
+// Write `cells` of a board evolving under `rule`, e.g. a copy taken earlier
+void save_snapshot(const std::string& path, const TwoDimBitMap& cells,
+                   const Rule& rule, uint64_t generation, bool tiles = false);
+// Copy the cells of `board` to `cells`, a map of the same size: one memcpy()
+// for a BitMapGameBoard, a word at a time for other boards
+void copy_cells(const AbstractGameBoard& board, TwoDimBitMap& cells);
+
+// Read the header of the snapshot at `path`. Throws std::runtime_error if
+// the file cannot be read or is not a valid snapshot.
+SnapshotInfo read_snapshot_info(const std::string& path);
+
+// Replace the cells of `board` with the snapshot at `path` and return its
+// header; the rule of the board is left as it is. A raw snapshot is mapped
+// copy-on-write into a BitMapGameBoard, so restoring costs no more than the
+// pages the board goes on to touch. Other boards and tiled snapshots are
+// copied. The cells are trusted to be as save_snapshot() wrote them, only
+// the header is checked. Throws std::invalid_argument if the board has
+// another size and std::runtime_error like read_snapshot_info().
+SnapshotInfo load_snapshot(const std::string& path, AbstractGameBoard& board);
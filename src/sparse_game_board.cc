@@ -0,0 +1,383 @@
+#include "sparse_game_board.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "life_kernel.hh"
+
+namespace {
+
+// Initial log2 of the capacity of the hash map
+constexpr int kInitialTableBits = 6;
+constexpr int kMask = SPARSE_CHUNK_SIZE - 1;
+
+// The rows of a chunk that is not allocated
+const uint64_t kDeadRows[SPARSE_CHUNK_SIZE] = {};
+
+}  // namespace
+
+SparseGameBoard::SparseGameBoard(int x_size, int y_size, const Rule& rule)
+    : x_size_(x_size), y_size_(y_size), rule_(rule) {
+  if (rule.births_from_nothing()) {
+    throw std::invalid_argument("SparseGameBoard does not support " +
+                                rule.to_string() + ", it has B0");
+  }
+  clear();
+}
+
+std::pair<int, int> SparseGameBoard::get_board_size() const {
+  return std::make_pair(x_size_, y_size_);
+}
+
+// ---------------------------------------------------------------------------
+//                             Chunk map
+// ---------------------------------------------------------------------------
+
+int SparseGameBoard::find_chunk(int cx, int cy) const {
+  const uint64_t key = chunk_key(cx, cy);
+  const size_t mask = table_.size() - 1;
+  for (size_t i = slot_of(key);; i = (i + 1) & mask) {
+    if (table_[i].chunk < 0) {
+      return -1;
+    }
+    if (table_[i].key == key) {
+      return table_[i].chunk;
+    }
+  }
+}
+
+int SparseGameBoard::get_or_create_chunk(int cx, int cy) {
+  int chunk = find_chunk(cx, cy);
+  if (chunk >= 0) {
+    return chunk;
+  }
+  // Keep the load factor at most 1/2, so probe sequences stay short
+  if (2 * (live_chunks_ + 1) > table_.size()) {
+    grow_table();
+  }
+  if (free_chunks_.empty()) {
+    chunk = static_cast<int>(pool_.size());
+    pool_.emplace_back();
+  } else {
+    chunk = free_chunks_.back();
+    free_chunks_.pop_back();
+  }
+  Chunk& c = pool_[chunk];
+  std::fill(&c.rows[0][0], &c.rows[0][0] + 2 * SPARSE_CHUNK_SIZE, 0);
+  c.cx = cx;
+  c.cy = cy;
+
+  const uint64_t key = chunk_key(cx, cy);
+  const size_t mask = table_.size() - 1;
+  size_t i = slot_of(key);
+  while (table_[i].chunk >= 0) {
+    i = (i + 1) & mask;
+  }
+  table_[i] = Slot{key, chunk};
+  live_chunks_++;
+  return chunk;
+}
+
+void SparseGameBoard::free_chunk(int cx, int cy) {
+  const uint64_t key = chunk_key(cx, cy);
+  const size_t mask = table_.size() - 1;
+  size_t i = slot_of(key);
+  while (table_[i].key != key || table_[i].chunk < 0) {
+    assert(table_[i].chunk >= 0);
+    i = (i + 1) & mask;
+  }
+  free_chunks_.push_back(table_[i].chunk);
+  live_chunks_--;
+
+  // Backward shift deletion: move later entries of the probe sequence into
+  // the hole unless that would put them before their home slot
+  for (size_t j = (i + 1) & mask; table_[j].chunk >= 0; j = (j + 1) & mask) {
+    size_t home = slot_of(table_[j].key);
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      table_[i] = table_[j];
+      i = j;
+    }
+  }
+  table_[i].chunk = -1;
+}
+
+void SparseGameBoard::compact() {
+  // Size the map for a load factor of at most 1/4, so it takes the live
+  // chunks doubling before it has to grow again
+  int bits = kInitialTableBits;
+  while ((size_t(1) << bits) < 4 * live_chunks_) {
+    bits++;
+  }
+  table_bits_ = bits;
+  std::vector<Slot> table(size_t(1) << bits, Slot{0, -1});
+  std::vector<Chunk> pool;
+  pool.reserve(live_chunks_);
+  const size_t mask = table.size() - 1;
+  for (const Slot& slot : table_) {
+    if (slot.chunk < 0) {
+      continue;
+    }
+    size_t i = slot_of(slot.key);
+    while (table[i].chunk >= 0) {
+      i = (i + 1) & mask;
+    }
+    table[i] = Slot{slot.key, static_cast<int>(pool.size())};
+    pool.push_back(pool_[slot.chunk]);
+  }
+  pool_.swap(pool);
+  table_.swap(table);
+  std::vector<int>().swap(free_chunks_);
+}
+
+void SparseGameBoard::grow_table() {
+  std::vector<Slot> old_table;
+  old_table.swap(table_);
+  table_bits_++;
+  table_.assign(size_t(1) << table_bits_, Slot{0, -1});
+  const size_t mask = table_.size() - 1;
+  for (const Slot& slot : old_table) {
+    if (slot.chunk < 0) {
+      continue;
+    }
+    size_t i = slot_of(slot.key);
+    while (table_[i].chunk >= 0) {
+      i = (i + 1) & mask;
+    }
+    table_[i] = slot;
+  }
+}
+
+const uint64_t* SparseGameBoard::chunk_rows(int cx, int cy) const {
+  int chunk = find_chunk(cx, cy);
+  return chunk < 0 ? kDeadRows : pool_[chunk].rows[front_];
+}
+
+// ---------------------------------------------------------------------------
+//                             Cells
+// ---------------------------------------------------------------------------
+
+// Chunk coordinates are the cell coordinates shifted right, which rounds
+// towards negative infinity, and the offset inside the chunk is the low bits
+bool SparseGameBoard::get_cell_state(int x, int y) const {
+  const uint64_t* rows =
+      chunk_rows(x >> SPARSE_CHUNK_SHIFT, y >> SPARSE_CHUNK_SHIFT);
+  return (rows[x & kMask] >> (y & kMask)) & 1;
+}
+
+void SparseGameBoard::set_cell_state(int x, int y, bool state) {
+  const int cx = x >> SPARSE_CHUNK_SHIFT, cy = y >> SPARSE_CHUNK_SHIFT;
+  if (state) {
+    int chunk = get_or_create_chunk(cx, cy);
+    pool_[chunk].rows[front_][x & kMask] |= 1UL << (y & kMask);
+  } else {
+    // Killing a cell never allocates, an emptied chunk is freed by update()
+    int chunk = find_chunk(cx, cy);
+    if (chunk >= 0) {
+      pool_[chunk].rows[front_][x & kMask] &= ~(1UL << (y & kMask));
+    }
+  }
+}
+
+// A chunk is one word wide, so word k of a row lies in the chunks with
+// cy = k
+static_assert(SPARSE_CHUNK_SIZE == 64, "A chunk row must be one word");
+
+uint64_t SparseGameBoard::get_word(int x, int k) const {
+  return chunk_rows(x >> SPARSE_CHUNK_SHIFT, k)[x & kMask];
+}
+
+void SparseGameBoard::set_word(int x, int k, uint64_t word) {
+  // The cells past the window are not part of the packed layout, they keep
+  // their state
+  const int cx = x >> SPARSE_CHUNK_SHIFT;
+  if (k == (y_size_ - 1) / 64 && y_size_ % 64) {
+    const uint64_t mask = (1UL << (y_size_ % 64)) - 1;
+    word = (word & mask) | (get_word(x, k) & ~mask);
+  }
+  // Like killing a cell, clearing a word never allocates
+  int chunk = word ? get_or_create_chunk(cx, k) : find_chunk(cx, k);
+  if (chunk >= 0) {
+    pool_[chunk].rows[front_][x & kMask] = word;
+  }
+}
+
+void SparseGameBoard::read_state_from(std::vector<bool>& vec) {
+  assert(vec.size() == (uint64_t)(x_size_ * y_size_));
+  clear();
+  int idx = 0;
+  for (int x = 0; x < x_size_; x++) {
+    for (int y = 0; y < y_size_; y++) {
+      if (vec[idx++]) {
+        set_cell_state(x, y, true);
+      }
+    }
+  }
+}
+
+void SparseGameBoard::clear() {
+  // Release the memory as well, the cleared board has no chunks
+  std::vector<Chunk>().swap(pool_);
+  std::vector<int>().swap(free_chunks_);
+  table_bits_ = kInitialTableBits;
+  std::vector<Slot>(size_t(1) << table_bits_, Slot{0, -1}).swap(table_);
+  live_chunks_ = 0;
+  computed_chunks_ = 0;
+  front_ = 0;
+}
+
+int SparseGameBoard::report_mem_usage() {
+  return pool_.capacity() * sizeof(Chunk) +
+         free_chunks_.capacity() * sizeof(int) +
+         table_.capacity() * sizeof(Slot);
+}
+
+int SparseGameBoard::count_live_neighbors(int x, int y) {
+  int count = 0;
+  for (int i = -1; i <= 1; i++) {
+    for (int j = -1; j <= 1; j++) {
+      if ((i != 0 || j != 0) && get_cell_state(x + i, y + j)) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+bool SparseGameBoard::calculate_next_state(int x, int y) {
+  return rule_.next_state(get_cell_state(x, y), count_live_neighbors(x, y));
+}
+
+// ---------------------------------------------------------------------------
+//                             Evolution
+// ---------------------------------------------------------------------------
+
+void SparseGameBoard::update() {
+  const int back = front_ ^ 1;
+
+  // Births only happen next to live cells, so every chunk with live cells on
+  // its border needs the neighbouring chunks on that side
+  std::vector<std::pair<int, int>> needed;
+  for (const Slot& slot : table_) {
+    if (slot.chunk < 0) {
+      continue;
+    }
+    const Chunk& c = pool_[slot.chunk];
+    const uint64_t* rows = c.rows[front_];
+    uint64_t any = 0;
+    for (int i = 0; i < SPARSE_CHUNK_SIZE; i++) {
+      any |= rows[i];
+    }
+    if (any == 0) {
+      continue;
+    }
+    const uint64_t first = rows[0], last = rows[SPARSE_CHUNK_SIZE - 1];
+    const uint64_t border[3][3] = {{first & 1, first, first >> 63},
+                                   {any & 1, 0, any >> 63},
+                                   {last & 1, last, last >> 63}};
+    for (int i = -1; i <= 1; i++) {
+      for (int j = -1; j <= 1; j++) {
+        if (border[i + 1][j + 1] && find_chunk(c.cx + i, c.cy + j) < 0) {
+          needed.emplace_back(c.cx + i, c.cy + j);
+        }
+      }
+    }
+  }
+  for (auto [cx, cy] : needed) {
+    get_or_create_chunk(cx, cy);
+  }
+  computed_chunks_ = live_chunks_;
+
+  // Run the bit-sliced kernel over every chunk. The rows are padded with the
+  // adjacent rows of the chunks above and below, and every row comes with
+  // the words of the chunks on its left and right.
+  std::vector<std::pair<int, int>> dead;
+  uint64_t padded[SPARSE_CHUNK_SIZE + 2][3];
+  dispatch_rule(rule_, [&](const auto& rule) {
+    for (const Slot& slot : table_) {
+      if (slot.chunk < 0) {
+        continue;
+      }
+      Chunk& c = pool_[slot.chunk];
+      const uint64_t* neighbors[3][3];
+      for (int i = -1; i <= 1; i++) {
+        for (int j = -1; j <= 1; j++) {
+          neighbors[i + 1][j + 1] = i == 0 && j == 0
+                                        ? c.rows[front_]
+                                        : chunk_rows(c.cx + i, c.cy + j);
+        }
+      }
+      for (int j = 0; j < 3; j++) {
+        padded[0][j] = neighbors[0][j][SPARSE_CHUNK_SIZE - 1];
+        for (int i = 0; i < SPARSE_CHUNK_SIZE; i++) {
+          padded[i + 1][j] = neighbors[1][j][i];
+        }
+        padded[SPARSE_CHUNK_SIZE + 1][j] = neighbors[2][j][0];
+      }
+
+      uint64_t any = 0;
+      for (int i = 0; i < SPARSE_CHUNK_SIZE; i++) {
+        const uint64_t* up = padded[i];
+        const uint64_t* mid = padded[i + 1];
+        const uint64_t* down = padded[i + 2];
+        uint64_t& out = c.rows[back][i];
+        rule_kernel(out, rule, up[0], up[1], up[2], mid[0], mid[1], mid[2],
+                    down[0], down[1], down[2]);
+        any |= out;
+      }
+      if (any == 0) {
+        dead.emplace_back(c.cx, c.cy);
+      }
+    }
+  });
+
+  int64_t start_ns = profile_clock_ns();
+  front_ = back;
+  for (auto [cx, cy] : dead) {
+    free_chunk(cx, cy);
+  }
+  // Give the memory of the dead chunks back once most of the pool is free.
+  // The pool has to shrink to a quarter of its size in between, so the
+  // copies cost O(1) per chunk freed.
+  if (4 * live_chunks_ < pool_.size()) {
+    compact();
+  }
+  profile_.swap_ns = profile_clock_ns() - start_ns;
+}
+
+uint64_t SparseGameBoard::population() const {
+  uint64_t count = 0;
+  for (const Slot& slot : table_) {
+    if (slot.chunk >= 0) {
+      count += popcount_words(pool_[slot.chunk].rows[front_],
+                              SPARSE_CHUNK_SIZE);
+    }
+  }
+  return count;
+}
+
+BoundingBox SparseGameBoard::bounding_box() const {
+  BoundingBox box;
+  for (const Slot& slot : table_) {
+    if (slot.chunk < 0) {
+      continue;
+    }
+    const Chunk& c = pool_[slot.chunk];
+    const uint64_t* rows = c.rows[front_];
+    uint64_t columns = 0;
+    int first = -1, last = -1;
+    for (int i = 0; i < SPARSE_CHUNK_SIZE; i++) {
+      columns |= rows[i];
+      if (rows[i]) {
+        first = first < 0 ? i : first;
+        last = i;
+      }
+    }
+    if (columns) {
+      const int x = c.cx * SPARSE_CHUNK_SIZE, y = c.cy * SPARSE_CHUNK_SIZE;
+      box.add(x + first, y + __builtin_ctzll(columns));
+      box.add(x + last, y + 63 - __builtin_clzll(columns));
+    }
+  }
+  return box;
+}
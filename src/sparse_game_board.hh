@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game_board.hh"
+
+// Log2 of the side of a chunk, a chunk holds 64 x 64 cells
+#define SPARSE_CHUNK_SHIFT 6
+#define SPARSE_CHUNK_SIZE (1 << SPARSE_CHUNK_SHIFT)
+
+/**
+ * Game board on an unbounded plane.
+ *
+ * Only the 64 x 64 chunks around live cells are stored. The chunks live in a
+ * pool and are looked up through an open-addressing hash map keyed by their
+ * chunk coordinates. Before every generation the board allocates the empty
+ * chunks next to live cells on the border of a chunk, since only those can
+ * see births; chunks that end up fully dead are returned to the pool, and
+ * once most of the pool is free the live chunks are moved into a smaller
+ * pool and map. Memory therefore scales with the number of live chunks, not
+ * with the bounding box of the pattern or the most chunks it ever had.
+ *
+ * Inside a chunk every row of 64 cells (fixed x, increasing y) is one word,
+ * like the rows of TwoDimBitMap, so the bit-sliced kernel updates a chunk 64
+ * cells at a time.
+ *
+ * Cells can be read and written at any coordinate, including negative ones.
+ * The size given to the constructor is only the window reported by
+ * get_board_size() and covered by read_state_from() and operator==.
+ * */
+class SparseGameBoard : public AbstractGameBoard {
+ public:
+  // Throws std::invalid_argument for rules with B0, since they would fill
+  // the whole plane
+  SparseGameBoard(int x_size, int y_size, const Rule& rule = Rule());
+  std::pair<int, int> get_board_size() const;
+  const Rule& get_rule() const { return rule_; }
+  bool get_cell_state(int x, int y) const;
+  void set_cell_state(int x, int y, bool state);
+  // A word of the packed layout is one row of a chunk
+  uint64_t get_word(int x, int k) const;
+  void set_word(int x, int k, uint64_t word);
+  void read_state_from(std::vector<bool>& vec);
+
+  void update();
+  void clear();
+
+  int report_mem_usage();
+
+  // Number of chunks currently allocated on the plane
+  size_t chunk_count() const { return live_chunks_; }
+
+  // Live cells on the whole plane, not only in the window
+  uint64_t population() const;
+  BoundingBox bounding_box() const;
+  // The cells of the chunks the last update() computed
+  uint64_t active_cells() const {
+    return computed_chunks_ * SPARSE_CHUNK_SIZE * SPARSE_CHUNK_SIZE;
+  }
+
+ protected:
+  int count_live_neighbors(int x, int y);
+  bool calculate_next_state(int x, int y);
+
+ private:
+  struct alignas(64) Chunk {
+    uint64_t rows[2][SPARSE_CHUNK_SIZE];  // Both generations of the chunk
+    int cx, cy;                           // The chunk coordinates
+  };
+  struct Slot {
+    uint64_t key;
+    int chunk;  // Index into `pool_`, -1 if the slot is empty
+  };
+
+  static uint64_t chunk_key(int cx, int cy) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32 |
+           static_cast<uint32_t>(cy);
+  }
+  // Home slot of `key` in the hash map
+  size_t slot_of(uint64_t key) const {
+    return (key * 0x9E3779B97F4A7C15UL) >> (64 - table_bits_);
+  }
+
+  // The chunk at (cx, cy), -1 if it is not allocated
+  int find_chunk(int cx, int cy) const;
+  // The chunk at (cx, cy), allocated from the pool if needed
+  int get_or_create_chunk(int cx, int cy);
+  // Return the chunk at (cx, cy) to the pool
+  void free_chunk(int cx, int cy);
+  // Double the capacity of the hash map
+  void grow_table();
+  // Move the live chunks into a pool and a map sized for them, releasing the
+  // free chunks
+  void compact();
+
+  // Current generation of a chunk, or all zeros if it is not allocated
+  const uint64_t* chunk_rows(int cx, int cy) const;
+
+  int x_size_, y_size_;  // The window reported by get_board_size()
+  Rule rule_;            // The rule of the game
+
+  std::vector<Chunk> pool_;       // Live and free chunks
+  std::vector<int> free_chunks_;  // Chunks in `pool_` that can be reused
+  std::vector<Slot> table_;       // Open-addressing (linear probing) map
+  int table_bits_;                // log2 of the capacity of `table_`
+  size_t live_chunks_;            // Number of chunks in `table_`
+  size_t computed_chunks_;        // Chunks computed by the last update()
+  int front_;                     // Generation of the chunks that is current
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bounded lock-free queue from one producer thread to one consumer thread.
+ *
+ * The producer only writes `tail_` and the consumer only writes `head_`;
+ * both are counters that never wrap in practice, and `Capacity` must be a
+ * power of two so the slot of a counter is a mask away.
+ * */
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0 && Capacity > 0,
+                "Capacity must be a power of two");
+
+ public:
+  // Producer: append `value`, returns false if the queue is full
+  bool push(const T& value) {
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    slots_[tail & (Capacity - 1)] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: take the oldest value, returns false if the queue is empty
+  bool pop(T& value) {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = slots_[head & (Capacity - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  T slots_[Capacity];
+  alignas(64) std::atomic<uint64_t> head_{0};  // Next slot to pop
+  alignas(64) std::atomic<uint64_t> tail_{0};  // Next slot to push
+};
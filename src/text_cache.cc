@@ -0,0 +1,88 @@
+#include "text_cache.hh"
+
+TextCache::TextCache(SDL_Renderer* renderer, TTF_Font* font)
+    : renderer_(renderer), font_(font) {
+  const std::string digits = "0123456789";
+  digits_ = render(digits, SDL_Color{255, 255, 255, 255});
+  // Measuring the prefixes keeps the spacing of the font between digits
+  digit_x_[0] = 0;
+  for (int d = 1; d <= 10; d++) {
+    int h;
+    TTF_SizeText(font_, digits.substr(0, d).c_str(), &digit_x_[d], &h);
+  }
+}
+
+TextCache::~TextCache() {
+  for (auto& entry : texts_) {
+    SDL_DestroyTexture(entry.second.texture);
+  }
+  SDL_DestroyTexture(digits_.texture);
+}
+
+void TextCache::draw(const std::string& text, SDL_Color color,
+                     const SDL_Rect& rect) {
+  const Text& cached = lookup(text, color);
+  if (cached.texture != nullptr) {
+    SDL_RenderCopy(renderer_, cached.texture, NULL, &rect);
+  }
+}
+
+void TextCache::draw_number(const std::string& label, uint64_t number,
+                            SDL_Color color, const SDL_Rect& rect) {
+  const Text& prefix = lookup(label, color);
+  const std::string digits = std::to_string(number);
+  // Lay the label and the digits out at their natural width, then scale
+  // every offset to the width of `rect`
+  int width = prefix.w;
+  for (char digit : digits) {
+    width += digit_x_[digit - '0' + 1] - digit_x_[digit - '0'];
+  }
+  if (width == 0 || digits_.texture == nullptr) {
+    return;
+  }
+  const double scale = double(rect.w) / width;
+  if (prefix.texture != nullptr) {
+    SDL_Rect dest = {rect.x, rect.y, int(prefix.w * scale), rect.h};
+    SDL_RenderCopy(renderer_, prefix.texture, NULL, &dest);
+  }
+  SDL_SetTextureColorMod(digits_.texture, color.r, color.g, color.b);
+  int x = prefix.w;
+  for (char digit : digits) {
+    const int d = digit - '0';
+    const int digit_width = digit_x_[d + 1] - digit_x_[d];
+    SDL_Rect source = {digit_x_[d], 0, digit_width, digits_.h};
+    SDL_Rect dest = {rect.x + int(x * scale), rect.y,
+                     int((x + digit_width) * scale) - int(x * scale), rect.h};
+    SDL_RenderCopy(renderer_, digits_.texture, &source, &dest);
+    x += digit_width;
+  }
+}
+
+const TextCache::Text& TextCache::lookup(const std::string& text,
+                                         SDL_Color color) {
+  const uint32_t rgba = uint32_t(color.r) << 24 | uint32_t(color.g) << 16 |
+                        uint32_t(color.b) << 8 | color.a;
+  auto key = std::make_pair(text, rgba);
+  auto it = texts_.find(key);
+  if (it != texts_.end()) {
+    return it->second;
+  }
+  if (texts_.size() == kMaxTexts) {
+    for (auto& entry : texts_) {
+      SDL_DestroyTexture(entry.second.texture);
+    }
+    texts_.clear();
+  }
+  return texts_.emplace(key, render(text, color)).first->second;
+}
+
+TextCache::Text TextCache::render(const std::string& text, SDL_Color color) {
+  SDL_Surface* surface = TTF_RenderText_Solid(font_, text.c_str(), color);
+  if (surface == nullptr) {
+    return Text{nullptr, 0, 0};
+  }
+  Text rendered = {SDL_CreateTextureFromSurface(renderer_, surface),
+                   surface->w, surface->h};
+  SDL_FreeSurface(surface);
+  return rendered;
+}
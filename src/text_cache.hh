@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+/**
+ * Textures of rendered text, so that text which stays the same from frame
+ * to frame is rasterized by SDL_ttf once rather than every frame.
+ *
+ * Strings are cached by text and color. Numbers, which change every frame,
+ * are drawn digit by digit from a single texture holding "0123456789"
+ * instead, so a counter never needs a new texture either.
+ * */
+class TextCache {
+ public:
+  TextCache(SDL_Renderer* renderer, TTF_Font* font);
+  ~TextCache();
+  TextCache(const TextCache&) = delete;
+  TextCache& operator=(const TextCache&) = delete;
+
+  // Draw `text` in `color`, stretched to `rect`
+  void draw(const std::string& text, SDL_Color color, const SDL_Rect& rect);
+  // Draw `label` followed by `number` in `color`, stretched to `rect` as a
+  // whole as if it was a single string
+  void draw_number(const std::string& label, uint64_t number, SDL_Color color,
+                   const SDL_Rect& rect);
+
+ private:
+  // A texture of rendered text and its size
+  struct Text {
+    SDL_Texture* texture;
+    int w, h;
+  };
+  // At most this many strings are kept; beyond that the cache starts over
+  static const size_t kMaxTexts = 256;
+
+  SDL_Renderer* renderer_;
+  TTF_Font* font_;
+  std::map<std::pair<std::string, uint32_t>, Text> texts_;
+  // "0123456789" in white, tinted with SDL_SetTextureColorMod(); digit d
+  // spans [digit_x_[d], digit_x_[d + 1]) of it
+  Text digits_;
+  int digit_x_[11];
+
+  // The cached texture of `text` in `color`, rendering it if needed
+  const Text& lookup(const std::string& text, SDL_Color color);
+  Text render(const std::string& text, SDL_Color color);
+};
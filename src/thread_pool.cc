@@ -0,0 +1,117 @@
+#include "thread_pool.hh"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// How many times a waiting thread polls before it blocks
+constexpr int kSpinIterations = 4000;
+
+// Poll `done` for a while, yielding the core between polls. Returns whether
+// `done` became true while spinning.
+template <typename Predicate>
+bool spin_until(Predicate done) {
+  for (int i = 0; i < kSpinIterations; i++) {
+    if (done()) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+void pin_to_core(std::thread& thread, int core) {
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(core, &cpu_set);
+  // Pinning is only a hint for locality, so failing to pin is not an error
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpu_set);
+#else
+  (void)thread;
+  (void)core;
+#endif
+}
+
+}  // namespace
+
+int ThreadPool::default_size() {
+  int n = static_cast<int>(std::thread::hardware_concurrency());
+  return n > 0 ? n : NTHR;
+}
+
+ThreadPool::ThreadPool(int num_threads, bool pin_threads) {
+  if (num_threads <= 0) {
+    num_threads = default_size();
+  }
+  int cores = default_size();
+  for (int tid = 1; tid < num_threads; tid++) {
+    workers_.emplace_back(&ThreadPool::worker_loop, this, tid);
+    if (pin_threads) {
+      pin_to_core(workers_.back(), tid % cores);
+    }
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_.store(true);
+  }
+  start_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::run(const std::function<void(int)>& task) {
+  if (workers_.empty()) {
+    task(0);
+    return;
+  }
+  task_ = &task;
+  pending_.store(static_cast<int>(workers_.size()));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_.fetch_add(1);
+  }
+  start_cv_.notify_all();
+
+  task(0);
+
+  auto all_done = [this] { return pending_.load() == 0; };
+  if (!spin_until(all_done)) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, all_done);
+  }
+  task_ = nullptr;
+}
+
+void ThreadPool::worker_loop(int tid) {
+  uint64_t seen = 0;
+  while (true) {
+    auto started = [this, seen] {
+      return generation_.load() != seen || stop_.load();
+    };
+    if (!spin_until(started)) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, started);
+    }
+    if (stop_.load()) {
+      return;
+    }
+    seen = generation_.load();
+
+    (*task_)(tid);
+
+    if (pending_.fetch_sub(1) == 1) {
+      // Take the lock so the notification cannot slip in between the
+      // caller checking `pending_` and going to sleep
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_cv_.notify_one();
+    }
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads to use when the number of cores cannot be detected
+#define NTHR 8
+
+/**
+ * A persistent pool of worker threads for data-parallel generations.
+ *
+ * The workers are started once and then parked between generations. `run`
+ * hands a task to every worker by bumping a generation counter, lets the
+ * calling thread execute its own share, and returns once all workers have
+ * reached the end of the generation, i.e. it acts as a barrier. Workers spin
+ * for a short while before blocking, so back-to-back generations do not pay
+ * for a futex wake-up.
+ * */
+class ThreadPool {
+ public:
+  // Start a pool running tasks on `num_threads` threads, including the thread
+  // calling `run`. 0 means one thread per hardware thread. If `pin_threads`
+  // is set, worker i is pinned to core i (modulo the number of cores).
+  explicit ThreadPool(int num_threads = 0, bool pin_threads = true);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Number of threads taking part in `run`, including the calling thread
+  int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Run task(tid) for every tid in [0, size()) in parallel and wait for all
+  // of them. The calling thread runs tid 0.
+  void run(const std::function<void(int)>& task);
+
+  // The default number of threads: one per hardware thread
+  static int default_size();
+
+ private:
+  void worker_loop(int tid);
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+
+  const std::function<void(int)>* task_{nullptr};  // Task of this generation
+  std::atomic<uint64_t> generation_{0};  // Bumped to start a generation
+  std::atomic<int> pending_{0};          // Workers still running the task
+  std::atomic<bool> stop_{false};
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free triple buffer handing the latest value from one writer thread to
+ * one reader thread.
+ *
+ * The writer fills back() and publish()es it; the reader acquire()s the
+ * latest published value into front(). The third buffer sits in between and
+ * is swapped with either side by a single atomic exchange, so neither thread
+ * ever waits for the other, and values published while the reader was busy
+ * are dropped in favour of newer ones.
+ * */
+template <typename T>
+class TripleBuffer {
+ public:
+  // All three buffers start as copies of `initial`
+  explicit TripleBuffer(const T& initial)
+      : buffers_{initial, initial, initial} {}
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // Writer: the buffer to fill next
+  T& back() { return buffers_[back_]; }
+  // Writer: make back() the latest value and get another buffer to fill
+  void publish() {
+    back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) &
+            kIndex;
+  }
+  // Whether the latest published value was not acquired yet, i.e. publishing
+  // now would drop it
+  bool pending() const {
+    return middle_.load(std::memory_order_acquire) & kFresh;
+  }
+
+  // Reader: make the latest published value front(). Returns false, keeping
+  // front() as it is, if nothing was published since the last call.
+  bool acquire() {
+    if (!(middle_.load(std::memory_order_relaxed) & kFresh)) {
+      return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+    return true;
+  }
+  // Reader: the value acquired last
+  const T& front() const { return buffers_[front_]; }
+
+ private:
+  static constexpr uint8_t kIndex = 3;  // Bits of `middle_` holding the index
+  static constexpr uint8_t kFresh = 4;  // Set while the middle is unread
+
+  T buffers_[3];
+  uint8_t back_ = 0;   // Owned by the writer
+  uint8_t front_ = 1;  // Owned by the reader
+  // The index of the buffer in between, and kFresh
+  alignas(64) std::atomic<uint8_t> middle_{2};
+};
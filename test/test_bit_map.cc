@@ -78,10 +78,42 @@ void boarder_test() {
   std::cout << "boarder_test passed!" << std::endl;
 }
 
+// test 3: Check the flat layout the word-level kernels rely on
+void layout_test() {
+  TwoDimBitMap bit_map(10, 130);
+  assert(bit_map.words_per_row() == 3);
+  // set the whole boarder
+  for (int x = 0; x < 10; x++) {
+    bit_map.set(x, 0);
+    bit_map.set(x, 129);
+  }
+  for (int y = 0; y < 130; y++) {
+    bit_map.set(0, y);
+    bit_map.set(9, y);
+  }
+  for (int i = -1; i <= 10; i++) {
+    // every row starts on a cache line
+    assert(reinterpret_cast<uintptr_t>(bit_map.row(i)) % 64 == 0);
+    // the ghost words around each row stay dead
+    assert(bit_map.row(i)[-1] == 0);
+    assert(bit_map.row(i)[bit_map.words_per_row()] == 0);
+  }
+  // the ghost rows stay dead
+  for (int k = 0; k < bit_map.words_per_row(); k++) {
+    assert(bit_map.row(-1)[k] == 0);
+    assert(bit_map.row(10)[k] == 0);
+  }
+  // bits past the end of a row stay dead
+  assert(bit_map.row(0)[2] == 3UL);
+
+  std::cout << "layout_test passed!" << std::endl;
+}
+
 int main() {
   // seed the random number generator
   srand(time(NULL));
   random_test();
   boarder_test();
+  layout_test();
   std::cout << "All tests passed" << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "test_harness.hh"
+
+// test 1: the unoptimized and the bit-sliced board agree under `Boundary`
+template <typename Boundary>
+void compare_test(int x_size, int y_size, int rounds) {
+  std::vector<bool> vec(x_size * y_size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    if (rand() < RAND_MAX / 2) {
+      vec[i] = true;
+    }
+  }
+  BasicGameBoard<Boundary> game_board(x_size, y_size);
+  BasicBitSlicedGameBoard<Boundary> bit_sliced_board(x_size, y_size);
+  game_board.read_state_from(vec);
+  bit_sliced_board.read_state_from(vec);
+  GameBoardTester tester(&game_board, &bit_sliced_board);
+  tester.run(rounds, {});
+  std::cout << tester.report_cpu_time() << std::endl;
+  std::cout << "compare_test " << Boundary::kName << " " << x_size << "x"
+            << y_size << " passed!" << std::endl;
+}
+
+// Check that exactly the cells in `alive` are alive
+void expect_cells(const AbstractGameBoard& board,
+                  const std::vector<std::pair<int, int>>& alive,
+                  const std::string& test) {
+  auto [x_size, y_size] = board.get_board_size();
+  for (int x = 0; x < x_size; x++) {
+    for (int y = 0; y < y_size; y++) {
+      bool expected = false;
+      for (auto cell : alive) {
+        expected |= cell == std::make_pair(x, y);
+      }
+      if (board.get_cell_state(x, y) != expected) {
+        throw std::runtime_error(test + ": wrong cell at (" +
+                                 std::to_string(x) + ", " + std::to_string(y) +
+                                 ")");
+      }
+    }
+  }
+}
+
+// test 2: a glider on a torus is back where it started once it has crossed
+// the board in both directions
+template <typename Board>
+void torus_glider_test() {
+  const int x_size = 32, y_size = 48;
+  Board board(x_size, y_size);
+  std::vector<std::pair<int, int>> glider = {
+      {1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  for (auto [x, y] : glider) {
+    board.set_cell_state(x, y, true);
+  }
+  // The glider moves one cell diagonally every 4 generations
+  for (int i = 0; i < 4 * 96; i++) {
+    board.update();
+  }
+  expect_cells(board, glider, "torus_glider_test");
+  std::cout << "torus_glider_test passed!" << std::endl;
+}
+
+// test 3: patterns split over the edges behave as the policy says
+template <template <typename> class Board>
+void edge_test() {
+  const int size = 16;
+  // On a torus the four corners form a block, which is a still life
+  std::vector<std::pair<int, int>> block = {
+      {0, 0}, {0, size - 1}, {size - 1, 0}, {size - 1, size - 1}};
+  Board<TorusBoundary> torus(size, size);
+  for (auto [x, y] : block) {
+    torus.set_cell_state(x, y, true);
+  }
+  torus.update();
+  expect_cells(torus, block, "edge_test torus");
+
+  // On a mirrored board a corner cell sees itself three times, so it
+  // survives on its own, while a dead boundary lets it die
+  Board<MirrorBoundary> mirror(size, size);
+  Board<DeadBoundary> dead(size, size);
+  mirror.set_cell_state(0, 0, true);
+  dead.set_cell_state(0, 0, true);
+  mirror.update();
+  dead.update();
+  expect_cells(mirror, {{0, 0}}, "edge_test mirror");
+  expect_cells(dead, {}, "edge_test dead");
+  std::cout << "edge_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  compare_test<TorusBoundary>(256, 256, 100);
+  compare_test<MirrorBoundary>(256, 256, 100);
+  // Rows that do not fill their last word, and rows that fill it exactly
+  compare_test<TorusBoundary>(200, 130, 100);
+  compare_test<MirrorBoundary>(200, 130, 100);
+  compare_test<TorusBoundary>(100, 64, 100);
+  compare_test<MirrorBoundary>(100, 64, 100);
+  torus_glider_test<BasicGameBoard<TorusBoundary>>();
+  torus_glider_test<BasicBitSlicedGameBoard<TorusBoundary>>();
+  edge_test<BasicGameBoard>();
+  edge_test<BasicBitSlicedGameBoard>();
+  std::cout << "All tests passed" << std::endl;
+}
@@ -0,0 +1,118 @@
+#include "checkpoint_writer.hh"
+
+#include <cstdio>
+
+#include "snapshot.hh"
+#include "test_harness.hh"
+
+const char* kPath = "test_checkpoint_writer.snap";
+
+// test 1: the snapshot holds the board as it was when it was submitted,
+// while the board runs on
+void submit_test() {
+  const int x_size = 300, y_size = 200;
+  std::vector<bool> vec(x_size * y_size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    vec[i] = rand() < RAND_MAX / 2;
+  }
+  for (bool tiles : {false, true}) {
+    BitSlicedGameBoard board(x_size, y_size);
+    GameBoard naive(x_size, y_size);
+    board.read_state_from(vec);
+    naive.read_state_from(vec);
+    BitSlicedGameBoard expected(x_size, y_size);
+    {
+      CheckpointWriter writer(kPath, tiles);
+      for (int generation = 1; generation <= 30; generation++) {
+        board.update();
+        naive.update();
+        if (generation % 10 == 0) {
+          if (!writer.submit(board, generation) ||
+              !writer.submit(naive, generation)) {
+            throw std::runtime_error("A blocking writer dropped a snapshot");
+          }
+          expected = board;
+        }
+      }
+      writer.flush();
+      if (writer.written() != 6 || writer.skipped() != 0 ||
+          writer.max_frames() != 2 || writer.copy_ns() > writer.stall_ns()) {
+        throw std::runtime_error("Wrong writer statistics");
+      }
+      SnapshotInfo info = read_snapshot_info(kPath);
+      if (info.generation != 30 || info.tiles != tiles) {
+        throw std::runtime_error("The last snapshot is not the last one");
+      }
+      // Submitted but not flushed: written when the writer goes away
+      board.update();
+      writer.submit(board, 31);
+      expected = board;
+      board.update();
+    }
+    BitSlicedGameBoard loaded(x_size, y_size);
+    if (load_snapshot(kPath, loaded).generation != 31 || loaded != expected) {
+      throw std::runtime_error("The snapshot changed with the board");
+    }
+  }
+  std::remove(kPath);
+  std::cout << "submit_test passed!" << std::endl;
+}
+
+// test 2: the memory bound and the backpressure policies
+void backpressure_test() {
+  const int x_size = 1024, y_size = 1024;
+  BitSlicedGameBoard board(x_size, y_size);
+  const size_t frame_bytes =
+      TwoDimBitMap::storage_words_for(x_size, y_size) * sizeof(uint64_t);
+  // Room for three frames
+  CheckpointWriter blocking(kPath, false, frame_bytes * 3 + 100);
+  for (int i = 0; i < 20; i++) {
+    blocking.submit(board, i);
+  }
+  blocking.flush();
+  if (blocking.max_frames() != 3 || blocking.written() != 20) {
+    throw std::runtime_error("Blocking writer lost snapshots");
+  }
+  // Less than one frame still allows one; whatever finds it taken is
+  // dropped
+  CheckpointWriter skipping(kPath, false, 1,
+                            CheckpointWriter::Backpressure::kSkip);
+  uint64_t accepted = 0;
+  for (int i = 0; i < 20; i++) {
+    accepted += skipping.submit(board, i);
+  }
+  skipping.flush();
+  if (skipping.max_frames() != 1 || accepted == 0 ||
+      skipping.written() != accepted ||
+      skipping.written() + skipping.skipped() != 20) {
+    throw std::runtime_error("Skipping writer miscounted");
+  }
+  std::remove(kPath);
+  std::cout << "backpressure_test passed!" << std::endl;
+}
+
+// test 3: errors of the writer thread reach the caller
+void error_test() {
+  GameBoard board(10, 10);
+  CheckpointWriter writer("no/such/directory/snapshot.snap", false);
+  writer.submit(board, 1);
+  try {
+    writer.flush();
+    throw std::runtime_error("The write error was lost");
+  } catch (const std::runtime_error& e) {
+    if (std::string(e.what()).find("Cannot create") == std::string::npos) {
+      throw;
+    }
+  }
+  // The error is reported once, the writer keeps going
+  writer.flush();
+  std::cout << "error_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  submit_test();
+  backpressure_test();
+  error_test();
+  std::cout << "All tests passed" << std::endl;
+}
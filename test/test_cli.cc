@@ -0,0 +1,127 @@
+#include <sstream>
+
+#include "board_factory.hh"
+#include "cli.hh"
+#include "test_harness.hh"
+
+Options parse(std::vector<const char*> args) {
+  args.insert(args.begin(), "game_of_life");
+  return parse_options(args.size(), args.data());
+}
+
+// test 1: flags are parsed in both forms, defaults are kept
+void parse_test() {
+  Options options = parse({"--headless", "--engine", "lut", "--size=300x200",
+                           "--rule", "B36/S23", "--seed", "42", "--god=0,2",
+                           "--generations", "7", "--threads", "3", "--format",
+                           "csv"});
+  if (!options.headless || options.help || options.engine != "lut" ||
+      options.x_size != 300 || options.y_size != 200 ||
+      options.rule != "B36/S23" || options.seed != 42 ||
+      options.gods != std::vector<int>{0, 2} || options.generations != 7 ||
+      options.threads != 3 || options.format != OutputFormat::kCsv ||
+      options.density != 0.5) {
+    throw std::runtime_error("Wrong options");
+  }
+  options = parse({"--size", "64"});
+  if (options.headless || options.x_size != 64 || options.y_size != 64 ||
+      options.engine != "threaded" || options.generations != 1000) {
+    throw std::runtime_error("Wrong square size or defaults");
+  }
+  options =
+      parse({"--pattern", "gun.rle", "--at=-5,70", "--save", "out.cells"});
+  if (options.pattern_file != "gun.rle" || options.pattern_x != -5 ||
+      options.pattern_y != 70 || options.save_file != "out.cells") {
+    throw std::runtime_error("Wrong pattern options");
+  }
+  if (parse({}).gens_per_sec != 0 ||
+      parse({"--gens-per-sec", "30"}).gens_per_sec != 30 ||
+      parse({}).gens_per_frame != 0 ||
+      parse({"--gens-per-frame=8"}).gens_per_frame != 8) {
+    throw std::runtime_error("Wrong speed");
+  }
+  options = parse({"--metrics", "m.jsonl", "--metrics-every=100",
+                   "--metrics-sample", "10"});
+  if (options.metrics_file != "m.jsonl" || options.metrics_every != 100 ||
+      options.metrics_sample != 10 || parse({}).metrics_sample != 1) {
+    throw std::runtime_error("Wrong metrics options");
+  }
+  for (std::vector<const char*> args :
+       {std::vector<const char*>{"--bogus"}, {"--size"}, {"--size", "0"},
+        {"--size", "12y"}, {"--generations", "ten"}, {"--format", "xml"},
+        {"--density", "2"}, {"--threads", "-1"}, {"--headless=1"},
+        {"--at", "5"}, {"--gens-per-sec", "-1"},
+        {"--gens-per-frame", "-2"}, {"--metrics-sample", "0"}}) {
+    try {
+      parse(args);
+      throw std::runtime_error(std::string("Accepted ") + args[0]);
+    } catch (const std::invalid_argument&) {
+    }
+  }
+  std::cout << "parse_test passed!" << std::endl;
+}
+
+// test 2: every engine of the factory runs like GameBoard
+void factory_test() {
+  const int x_size = 100, y_size = 130;
+  // The soup cannot reach the edge within 30 rounds, where the unbounded
+  // sparse board would differ
+  std::vector<bool> vec(x_size * y_size);
+  for (int x = 35; x < 65; x++) {
+    for (int y = 40; y < 90; y++) {
+      if (rand() < RAND_MAX / 2) {
+        vec[x * y_size + y] = true;
+      }
+    }
+  }
+  const MultiStateRule rule = Rule::parse("B36/S23");
+  GameBoard game_board(x_size, y_size, rule.to_life_like());
+  game_board.read_state_from(vec);
+  for (const EngineInfo& engine : engines()) {
+    GameBoard reference = game_board;
+    std::unique_ptr<AbstractGameBoard> board =
+        make_game_board(engine.name, x_size, y_size, rule, 2);
+    board->read_state_from(vec);
+    GameBoardTester tester(&reference, board.get());
+    tester.run(30, {});
+  }
+  try {
+    make_game_board("quantum", 10, 10);
+    throw std::runtime_error("Built an unknown engine");
+  } catch (const std::invalid_argument&) {
+  }
+  try {
+    make_game_board("lut", 10, 10, MultiStateRule::parse("B2/S/C3"));
+    throw std::runtime_error("lut accepted a Generations rule");
+  } catch (const std::invalid_argument&) {
+  }
+  make_game_board("multistate", 10, 10, MultiStateRule::parse("B2/S/C3"));
+  std::cout << "factory_test passed!" << std::endl;
+}
+
+// test 3: all formats report the run
+void report_test() {
+  Options options = parse({"--rule", "R5,C0,M1,S34..58,B34..45,NM"});
+  RunReport report{10, 2000, 123, 456};
+  for (OutputFormat format :
+       {OutputFormat::kText, OutputFormat::kCsv, OutputFormat::kJson}) {
+    options.format = format;
+    std::stringstream out;
+    write_report(out, options, report);
+    for (const char* expected : {"threaded", "R5,C0,M1", "123", "456"}) {
+      if (out.str().find(expected) == std::string::npos) {
+        throw std::runtime_error("Missing " + std::string(expected) +
+                                 " in " + out.str());
+      }
+    }
+  }
+  std::cout << "report_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  parse_test();
+  factory_test();
+  report_test();
+  std::cout << "All tests passed" << std::endl;
+}
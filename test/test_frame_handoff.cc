@@ -0,0 +1,129 @@
+#include <array>
+#include <thread>
+
+#include "spsc_queue.hh"
+#include "test_harness.hh"
+#include "triple_buffer.hh"
+
+// A value that is torn if its words disagree
+using Value = std::array<uint64_t, 16>;
+
+Value make_value(uint64_t n) {
+  Value value;
+  value.fill(n);
+  return value;
+}
+
+// test 1: only the latest published value is acquired, and only once
+void triple_buffer_test() {
+  TripleBuffer<Value> buffer(make_value(0));
+  if (buffer.acquire() || buffer.front()[0] != 0 || buffer.pending()) {
+    throw std::runtime_error("Acquired before publishing");
+  }
+  for (uint64_t n = 1; n <= 3; n++) {
+    buffer.back() = make_value(n);
+    buffer.publish();
+  }
+  if (!buffer.pending() || !buffer.acquire() || buffer.front()[0] != 3) {
+    throw std::runtime_error("Latest value not acquired");
+  }
+  if (buffer.pending() || buffer.acquire() || buffer.front()[0] != 3) {
+    throw std::runtime_error("Value acquired twice");
+  }
+  std::cout << "triple_buffer_test passed!" << std::endl;
+}
+
+// test 2: a reader racing a writer sees whole values in increasing order,
+// ending with the last one
+void triple_buffer_threads_test() {
+  const uint64_t values = 200000;
+  TripleBuffer<Value> buffer(make_value(0));
+  std::thread writer([&] {
+    for (uint64_t n = 1; n <= values; n++) {
+      buffer.back() = make_value(n);
+      buffer.publish();
+    }
+  });
+  uint64_t last = 0, acquired = 0;
+  while (last != values) {
+    if (!buffer.acquire()) {
+      std::this_thread::yield();
+      continue;
+    }
+    const Value& value = buffer.front();
+    for (uint64_t word : value) {
+      if (word != value[0]) {
+        throw std::runtime_error("Torn value " + std::to_string(value[0]));
+      }
+    }
+    if (value[0] <= last) {
+      throw std::runtime_error("Value " + std::to_string(value[0]) +
+                               " after " + std::to_string(last));
+    }
+    last = value[0];
+    acquired++;
+  }
+  writer.join();
+  std::cout << "Acquired " << acquired << " of " << values << " values"
+            << std::endl;
+  std::cout << "triple_buffer_threads_test passed!" << std::endl;
+}
+
+// test 3: the queue keeps the order and refuses values when full
+void spsc_queue_test() {
+  SpscQueue<int, 4> queue;
+  int value;
+  if (queue.pop(value)) {
+    throw std::runtime_error("Popped from an empty queue");
+  }
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 4; i++) {
+      if (!queue.push(round * 10 + i)) {
+        throw std::runtime_error("Queue full too early");
+      }
+    }
+    if (queue.push(-1)) {
+      throw std::runtime_error("Pushed to a full queue");
+    }
+    for (int i = 0; i < 4; i++) {
+      if (!queue.pop(value) || value != round * 10 + i) {
+        throw std::runtime_error("Wrong value popped");
+      }
+    }
+  }
+  std::cout << "spsc_queue_test passed!" << std::endl;
+}
+
+// test 4: values pushed by one thread are popped by another in order, none
+// lost
+void spsc_queue_threads_test() {
+  const int values = 500000;
+  SpscQueue<int, 64> queue;
+  std::thread producer([&] {
+    for (int i = 0; i < values; i++) {
+      while (!queue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (int i = 0; i < values; i++) {
+    int value;
+    while (!queue.pop(value)) {
+      std::this_thread::yield();
+    }
+    if (value != i) {
+      throw std::runtime_error("Popped " + std::to_string(value) +
+                               " instead of " + std::to_string(i));
+    }
+  }
+  producer.join();
+  std::cout << "spsc_queue_threads_test passed!" << std::endl;
+}
+
+int main() {
+  triple_buffer_test();
+  triple_buffer_threads_test();
+  spsc_queue_test();
+  spsc_queue_threads_test();
+  std::cout << "All tests passed" << std::endl;
+}
@@ -0,0 +1,83 @@
+#include "game.hh"
+
+#include <algorithm>
+#include <sstream>
+#include <tuple>
+
+#include "board_factory.hh"
+#include "test_harness.hh"
+
+// Run `board` headless from `vec` for `rounds` rounds, recording metrics
+// if `metrics` is given
+void run_headless(AbstractGameBoard* board, std::vector<bool>& vec,
+                  int rounds, std::ostream* metrics = nullptr) {
+  board->read_state_from(vec);
+  Game game(board, {}, true, 0, rounds, true);
+  if (metrics != nullptr) {
+    game.set_metrics(1, metrics, 10);
+  }
+  game.run();
+}
+
+// test 1: headless runs hand many generations to advance() at once, and
+// still match GameBoard on random boards whose cells reach the edges
+void headless_test() {
+  for (auto [x_size, y_size, rounds] :
+       {std::tuple<int, int, int>{64, 64, 100}, {100, 37, 300}}) {
+    std::vector<bool> vec(x_size * y_size);
+    for (uint64_t i = 0; i < vec.size(); i++) {
+      vec[i] = rand() < RAND_MAX / 2;
+    }
+    GameBoard reference(x_size, y_size);
+    reference.read_state_from(vec);
+    for (int i = 0; i < rounds; i++) {
+      reference.update();
+    }
+    for (const char* engine : {"hashlife", "lut"}) {
+      std::unique_ptr<AbstractGameBoard> board =
+          make_game_board(engine, x_size, y_size);
+      run_headless(board.get(), vec, rounds);
+      if (*board != reference) {
+        throw std::runtime_error(std::string(engine) +
+                                 ": headless run differs from GameBoard");
+      }
+    }
+  }
+  std::cout << "headless_test passed!" << std::endl;
+}
+
+// test 2: recording metrics steps every generation instead of advancing,
+// which must not change the generations computed
+void metrics_test() {
+  const int size = 80, rounds = 150;
+  std::vector<bool> vec(size * size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    vec[i] = rand() < RAND_MAX / 2;
+  }
+  for (const char* engine : {"hashlife", "tiled"}) {
+    std::unique_ptr<AbstractGameBoard> plain =
+        make_game_board(engine, size, size);
+    std::unique_ptr<AbstractGameBoard> measured =
+        make_game_board(engine, size, size);
+    std::ostringstream metrics;
+    run_headless(plain.get(), vec, rounds);
+    run_headless(measured.get(), vec, rounds, &metrics);
+    if (*plain != *measured) {
+      throw std::runtime_error(std::string(engine) +
+                               ": metrics changed the headless run");
+    }
+    const std::string lines = metrics.str();
+    if (std::count(lines.begin(), lines.end(), '\n') != rounds / 10) {
+      throw std::runtime_error(std::string(engine) +
+                               ": wrong number of metrics lines");
+    }
+  }
+  std::cout << "metrics_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  headless_test();
+  metrics_test();
+  std::cout << "All tests passed" << std::endl;
+}
@@ -1,6 +1,9 @@
 #include "test_harness.hh"
 
-void test_game_board(int x_size, int y_size, int rounds) {
+// Run the unoptimized GameBoard and `AlternativeGameBoard` side by side and
+// check that they agree after every round
+template <typename AlternativeGameBoard, typename... Args>
+void test_game_board(int x_size, int y_size, int rounds, Args... args) {
   std::vector<bool> vec(x_size * y_size);
   for (uint64_t i = 0; i < vec.size(); i++) {
     if (rand() < RAND_MAX / 2) {
@@ -9,7 +12,7 @@ void test_game_board(int x_size, int y_size, int rounds) {
   }
   AbstractGameBoard* game_board = new GameBoard(x_size, y_size);
   AbstractGameBoard* alternative_game_board =
-      new FullyOptimizedGameBoard(x_size, y_size);
+      new AlternativeGameBoard(x_size, y_size, args...);
   game_board->read_state_from(vec);
   alternative_game_board->read_state_from(vec);
   GameBoardTester tester(game_board, alternative_game_board);
@@ -19,12 +22,123 @@ void test_game_board(int x_size, int y_size, int rounds) {
   delete alternative_game_board;
 }
 
+// Same as test_game_board, but both boards run under `rule`, which is passed
+// to AlternativeGameBoard after `args`
+template <typename AlternativeGameBoard, typename... Args>
+void test_rule(const Rule& rule, int x_size, int y_size, int rounds,
+               Args... args) {
+  std::vector<bool> vec(x_size * y_size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    if (rand() < RAND_MAX / 2) {
+      vec[i] = true;
+    }
+  }
+  AbstractGameBoard* game_board = new GameBoard(x_size, y_size, rule);
+  AbstractGameBoard* alternative_game_board =
+      new AlternativeGameBoard(x_size, y_size, args..., rule);
+  if (alternative_game_board->get_rule() != rule) {
+    throw std::runtime_error("The board does not run " + rule.to_string());
+  }
+  game_board->read_state_from(vec);
+  alternative_game_board->read_state_from(vec);
+  GameBoardTester tester(game_board, alternative_game_board);
+  tester.run(rounds, {});
+  delete game_board;
+  delete alternative_game_board;
+}
+
+// Keeps dropping a block into the board, so tiles that went quiet have to
+// pick up cells set from outside of update()
+void seed_block(AbstractGameBoard* board) {
+  board->set_cell_state(100, 100, true);
+  board->set_cell_state(100, 101, true);
+  board->set_cell_state(101, 100, true);
+  board->set_cell_state(101, 101, true);
+}
+
+// A sparse board that quickly settles down, with a glider crossing the tiles
+template <typename AlternativeGameBoard>
+void test_sparse_game_board(int x_size, int y_size, int rounds) {
+  std::vector<bool> vec(x_size * y_size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    if (rand() < RAND_MAX / 20) {
+      vec[i] = true;
+    }
+  }
+  // glider heading towards increasing x and y
+  for (auto [x, y] : {std::make_pair(11, 10), std::make_pair(12, 11),
+                      std::make_pair(10, 12), std::make_pair(11, 12),
+                      std::make_pair(12, 12)}) {
+    vec[x * y_size + y] = true;
+  }
+  AbstractGameBoard* game_board = new GameBoard(x_size, y_size);
+  AbstractGameBoard* alternative_game_board =
+      new AlternativeGameBoard(x_size, y_size);
+  game_board->read_state_from(vec);
+  alternative_game_board->read_state_from(vec);
+  GameBoardTester tester(game_board, alternative_game_board);
+  tester.run(rounds, {});
+  tester.run(rounds, {seed_block});
+  std::cout << tester.report_cpu_time() << std::endl;
+  delete game_board;
+  delete alternative_game_board;
+}
+
 int main() {
   std::cout << "*** Verification Test: 256x256 board, run 100 rounds"
             << std::endl;
-  test_game_board(256, 256, 100);
+  test_game_board<FullyOptimizedGameBoard>(256, 256, 100);
+  // A thread count that does not divide the rows evenly
+  test_game_board<FullyOptimizedGameBoard>(256, 256, 100, 3);
+  // Two boards sharing one pool
+  auto pool = std::make_shared<ThreadPool>(4);
+  test_game_board<FullyOptimizedGameBoard>(256, 256, 100, pool);
+  test_game_board<FullyOptimizedGameBoard>(200, 130, 100, pool);
+  test_game_board<BitSlicedGameBoard>(256, 256, 100);
+  test_game_board<TiledGameBoard>(256, 256, 100);
+  test_game_board<LutGameBoard>(256, 256, 100);
+  for (SimdIsa isa : {SimdIsa::kScalar, SimdIsa::kAvx2, SimdIsa::kAvx512}) {
+    if (simd_isa_supported(isa)) {
+      std::cout << "SIMD kernel: " << simd_isa_name(isa) << std::endl;
+      test_game_board<SimdGameBoard>(256, 256, 100, isa);
+      // Row lengths that leave a scalar tail after the vector loop
+      test_game_board<SimdGameBoard>(100, 1000, 100, isa);
+      test_game_board<SimdGameBoard>(100, 70, 100, isa);
+    }
+  }
+  std::cout << "=== PASS: Verification Test" << std::endl;
+  // The row length is not a multiple of 64, so the last word of every row
+  // is only partially used
+  std::cout << "*** Verification Test: 200x130 board, run 100 rounds"
+            << std::endl;
+  test_game_board<BitSlicedGameBoard>(200, 130, 100);
+  test_game_board<TiledGameBoard>(200, 130, 100);
+  // An odd number of rows leaves the last block half outside the board
+  test_game_board<LutGameBoard>(201, 130, 100);
+  std::cout << "=== PASS: Verification Test" << std::endl;
+  std::cout << "*** Verification Test: sparse 300x200 board, run 400 rounds"
+            << std::endl;
+  test_sparse_game_board<TiledGameBoard>(300, 200, 200);
   std::cout << "=== PASS: Verification Test" << std::endl;
+  // The hot rules with specialized kernels, a generic one and one with B0
+  for (const char* rule : {"B3/S23", "B36/S23", "B3678/S34678", "B2/S",
+                           "B1357/S1357", "B0123478/S34678"}) {
+    std::cout << "*** Verification Test: " << rule
+              << ", 130x100 board, run 30 rounds" << std::endl;
+    Rule r = Rule::parse(rule);
+    test_rule<OptimizedGameBoard>(r, 130, 100, 30);
+    test_rule<FullyOptimizedGameBoard>(r, 130, 100, 30, 0);
+    test_rule<BitSlicedGameBoard>(r, 130, 100, 30);
+    test_rule<LutGameBoard>(r, 130, 100, 30);
+    test_rule<TiledGameBoard>(r, 130, 100, 30);
+    for (SimdIsa isa : {SimdIsa::kScalar, SimdIsa::kAvx2, SimdIsa::kAvx512}) {
+      if (simd_isa_supported(isa)) {
+        test_rule<SimdGameBoard>(r, 130, 100, 30, isa);
+      }
+    }
+    std::cout << "=== PASS: Verification Test" << std::endl;
+  }
   std::cout << "*** Speed Test: 2048x2048 board, run 1000 rounds" << std::endl;
-  test_game_board(2048, 2048, 1000);
+  test_game_board<FullyOptimizedGameBoard>(2048, 2048, 1000);
   std::cout << "=== PASS: Speed Test" << std::endl;
 }
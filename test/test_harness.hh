@@ -78,6 +78,31 @@ class GameBoardTester {
     }
   }
 
+  // Advance the game board `generations` rounds with update() and the
+  // alternative game board with a single advance(), then compare them
+  void advance(uint64_t generations) {
+    auto begin = std::chrono::high_resolution_clock::now();
+    for (uint64_t i = 0; i < generations; i++) {
+      game_board_->update();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    game_board_cpu_time_ +=
+        std::chrono::duration_cast<std::chrono::milliseconds>(end - begin)
+            .count();
+
+    begin = std::chrono::high_resolution_clock::now();
+    alternative_game_board_->advance(generations);
+    end = std::chrono::high_resolution_clock::now();
+    alternative_game_board_cpu_time_ +=
+        std::chrono::duration_cast<std::chrono::milliseconds>(end - begin)
+            .count();
+
+    if (*game_board_ != *alternative_game_board_) {
+      throw std::runtime_error("Game boards are not equal after advancing " +
+                               std::to_string(generations) + " rounds");
+    }
+  }
+
   std::string report_cpu_time() {
     return "Game board CPU time: " + std::to_string(game_board_cpu_time_) +
            "ms, Alternative game board CPU time: " +
@@ -0,0 +1,162 @@
+#include "hash_life.hh"
+#include "test_harness.hh"
+
+// test 1: update() matches GameBoard on random boards
+void update_test(int x_size, int y_size, int rounds) {
+  std::vector<bool> vec(x_size * y_size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    if (rand() < RAND_MAX / 2) {
+      vec[i] = true;
+    }
+  }
+  GameBoard game_board(x_size, y_size);
+  HashLifeGameBoard hash_life_board(x_size, y_size);
+  game_board.read_state_from(vec);
+  hash_life_board.read_state_from(vec);
+  GameBoardTester tester(&game_board, &hash_life_board);
+  tester.run(rounds, {});
+  std::cout << tester.report_cpu_time() << std::endl;
+  std::cout << "update_test " << x_size << "x" << y_size << " passed!"
+            << std::endl;
+}
+
+// test 2: advance() matches the same number of updates while the pattern
+// stays clear of the edge of the board
+void advance_test() {
+  const int size = 512;
+  // A random soup in the center, it cannot reach the edge within 128 rounds
+  GameBoard game_board(size, size);
+  HashLifeGameBoard hash_life_board(size, size);
+  for (int x = size / 2 - 16; x < size / 2 + 16; x++) {
+    for (int y = size / 2 - 16; y < size / 2 + 16; y++) {
+      if (rand() < RAND_MAX / 2) {
+        game_board.set_cell_state(x, y, true);
+        hash_life_board.set_cell_state(x, y, true);
+      }
+    }
+  }
+  int generation = 0;
+  for (int jump : {1, 2, 5, 8, 16, 32, 64}) {
+    for (int i = 0; i < jump; i++) {
+      game_board.update();
+    }
+    hash_life_board.advance(jump);
+    generation += jump;
+    if (game_board != hash_life_board) {
+      throw std::runtime_error("advance() diverged at generation " +
+                               std::to_string(generation));
+    }
+  }
+  std::cout << "advance_test passed!" << std::endl;
+}
+
+// test 3: deep jumps on a periodic pattern and garbage collection
+void deep_jump_test() {
+  // A small node cache, so the collector has to run during the jumps
+  HashLifeGameBoard board(1024, 1024, 1 << 12);
+  // A row of blinkers, period 2
+  for (int x = 100; x < 900; x += 8) {
+    board.set_cell_state(x, 500, true);
+    board.set_cell_state(x + 1, 500, true);
+    board.set_cell_state(x + 2, 500, true);
+  }
+  // Glider below the blinkers. Like on GameBoard, it crashes into the bottom
+  // edge of the board within 160 generations and leaves a block there.
+  board.set_cell_state(11, 990, true);
+  board.set_cell_state(12, 991, true);
+  board.set_cell_state(10, 992, true);
+  board.set_cell_state(11, 992, true);
+  board.set_cell_state(12, 992, true);
+
+  board.advance(1UL << 20);
+  board.advance(1000000);
+  // Both jumps are even, so every blinker is back in its initial phase, and
+  // the block is still there
+  for (int x = 0; x < 1024; x++) {
+    for (int y = 0; y < 1024; y++) {
+      bool blinker = y == 500 && x >= 100 && x < 900 && (x - 100) % 8 < 3;
+      bool block = x >= 42 && x <= 43 && y >= 1022;
+      if (board.get_cell_state(x, y) != (blinker || block)) {
+        throw std::runtime_error("Wrong cell after the deep jump at (" +
+                                 std::to_string(x) + ", " + std::to_string(y) +
+                                 ")");
+      }
+    }
+  }
+  board.collect_garbage();
+  std::cout << "Nodes after garbage collection: " << board.node_count()
+            << std::endl;
+  std::cout << "deep_jump_test passed!" << std::endl;
+}
+
+// test 4: advance() matches update() on boards whose cells reach the edge,
+// where the jumps have to shrink to single generations
+void edge_advance_test() {
+  for (int size : {64, 100}) {
+    std::vector<bool> vec(size * size);
+    for (uint64_t i = 0; i < vec.size(); i++) {
+      vec[i] = rand() < RAND_MAX / 2;
+    }
+    GameBoard game_board(size, size);
+    HashLifeGameBoard hash_life_board(size, size);
+    game_board.read_state_from(vec);
+    hash_life_board.read_state_from(vec);
+    GameBoardTester tester(&game_board, &hash_life_board);
+    for (uint64_t generations : {100, 1, 7, 64, 300}) {
+      tester.advance(generations);
+    }
+  }
+  // A glider that flies into the corner from far away: the first jumps are
+  // large, the last ones have to stop short of the edge
+  GameBoard game_board(512, 512);
+  HashLifeGameBoard hash_life_board(512, 512);
+  for (AbstractGameBoard* board :
+       std::vector<AbstractGameBoard*>{&game_board, &hash_life_board}) {
+    board->set_cell_state(301, 300, true);
+    board->set_cell_state(302, 301, true);
+    board->set_cell_state(300, 302, true);
+    board->set_cell_state(301, 302, true);
+    board->set_cell_state(302, 302, true);
+  }
+  GameBoardTester tester(&game_board, &hash_life_board);
+  tester.advance(1000);
+  std::cout << "edge_advance_test passed!" << std::endl;
+}
+
+// test 5: other rules, and rules HashLife cannot run
+void rule_test() {
+  for (const char* rule : {"B36/S23", "B3678/S34678", "B2/S", "B1357/S1357"}) {
+    const int x_size = 100, y_size = 70;
+    std::vector<bool> vec(x_size * y_size);
+    for (uint64_t i = 0; i < vec.size(); i++) {
+      if (rand() < RAND_MAX / 2) {
+        vec[i] = true;
+      }
+    }
+    GameBoard game_board(x_size, y_size, Rule::parse(rule));
+    HashLifeGameBoard hash_life_board(x_size, y_size, HASHLIFE_MAX_NODES,
+                                      Rule::parse(rule));
+    game_board.read_state_from(vec);
+    hash_life_board.read_state_from(vec);
+    GameBoardTester tester(&game_board, &hash_life_board);
+    tester.run(30, {});
+  }
+  try {
+    HashLifeGameBoard board(64, 64, HASHLIFE_MAX_NODES, Rule::parse("B03/S23"));
+    throw std::runtime_error("HashLife accepted a rule with B0");
+  } catch (const std::invalid_argument&) {
+  }
+  std::cout << "rule_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  update_test(256, 256, 100);
+  // Not a power of two, the board does not fill the quadtree
+  update_test(100, 37, 100);
+  advance_test();
+  deep_jump_test();
+  edge_advance_test();
+  rule_test();
+  std::cout << "All tests passed" << std::endl;
+}
@@ -0,0 +1,183 @@
+#include "metrics.hh"
+
+#include <algorithm>
+
+#include "board_factory.hh"
+#include "sparse_game_board.hh"
+#include "test_harness.hh"
+
+// test 1: percentiles are within the relative error of the histogram
+void histogram_test() {
+  LatencyHistogram histogram;
+  std::vector<int64_t> values;
+  for (int i = 0; i < 100000; i++) {
+    // Mostly fast, with a long tail
+    int64_t ns = rand() % 1000 + (rand() % 100 == 0 ? rand() % 10000000 : 0);
+    values.push_back(ns);
+    histogram.record(ns);
+  }
+  std::sort(values.begin(), values.end());
+  for (double p : {0.0, 0.5, 0.9, 0.99, 0.999, 1.0}) {
+    size_t rank = std::max<size_t>(1, p * values.size() + 0.5);
+    int64_t exact = values[rank - 1];
+    int64_t estimate = histogram.percentile(p);
+    if (estimate < exact || estimate > exact + exact / 8) {
+      throw std::runtime_error("p" + std::to_string(p) + " is " +
+                               std::to_string(estimate) + " instead of " +
+                               std::to_string(exact));
+    }
+  }
+  if (histogram.count() != values.size() || histogram.min() != values[0] ||
+      histogram.max() != values.back()) {
+    throw std::runtime_error("Wrong count, min or max");
+  }
+  histogram.clear();
+  if (histogram.count() != 0 || histogram.percentile(0.5) != 0) {
+    throw std::runtime_error("The histogram was not cleared");
+  }
+  std::cout << "histogram_test passed!" << std::endl;
+}
+
+// test 2: population() matches the cells of every board
+void population_test() {
+  const int x_size = 100, y_size = 130;
+  std::vector<bool> vec(x_size * y_size);
+  uint64_t expected = 0;
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    vec[i] = rand() < RAND_MAX / 3;
+    expected += vec[i];
+  }
+  GameBoard game_board(x_size, y_size);
+  TiledGameBoard tiled_board(x_size, y_size);
+  SparseGameBoard sparse_board(x_size, y_size);
+  for (AbstractGameBoard* board : std::vector<AbstractGameBoard*>{
+           &game_board, &tiled_board, &sparse_board}) {
+    board->read_state_from(vec);
+    if (board->population() != expected) {
+      throw std::runtime_error("Wrong population before update()");
+    }
+  }
+  game_board.update();
+  tiled_board.update();
+  if (tiled_board.population() != game_board.population()) {
+    throw std::runtime_error("Wrong population after update()");
+  }
+  // The sparse board counts the cells outside of the window, too
+  sparse_board.set_cell_state(-1000, 5000, true);
+  if (sparse_board.population() != expected + 1) {
+    throw std::runtime_error("Sparse board missed cells outside the window");
+  }
+  std::cout << "population_test passed!" << std::endl;
+}
+
+// test 3: population() and bounding_box() of every engine follow the board
+// through updates and writes
+void statistics_test() {
+  const int x_size = 150, y_size = 200;
+  std::vector<bool> vec(x_size * y_size);
+  for (int x = 40; x < 110; x++) {
+    for (int y = 50; y < 130; y++) {
+      vec[x * y_size + y] = rand() < RAND_MAX / 2;
+    }
+  }
+  for (const EngineInfo& engine : engines()) {
+    GameBoard reference(x_size, y_size);
+    std::unique_ptr<AbstractGameBoard> board =
+        make_game_board(engine.name, x_size, y_size);
+    reference.read_state_from(vec);
+    board->read_state_from(vec);
+    for (int round = 0; round < 20; round++) {
+      // Writes between generations, including ones that change nothing
+      int x = rand() % x_size, y = rand() % y_size;
+      bool state = rand() % 2;
+      reference.set_cell_state(x, y, state);
+      board->set_cell_state(x, y, state);
+      board->set_cell_state(x, y, state);
+      if (board->population() != reference.population() ||
+          !(board->bounding_box() == reference.bounding_box())) {
+        throw std::runtime_error(std::string(engine.name) +
+                                 ": wrong statistics in round " +
+                                 std::to_string(round));
+      }
+      reference.update();
+      board->update();
+    }
+    board->clear();
+    if (board->population() != 0 || !board->bounding_box().empty()) {
+      throw std::runtime_error(std::string(engine.name) + ": not cleared");
+    }
+  }
+
+  // Rows and tiles add up to the population
+  BitSlicedGameBoard board(x_size, y_size);
+  board.read_state_from(vec);
+  uint64_t rows = 0, tiles = 0;
+  for (uint32_t count : board.row_population()) {
+    rows += count;
+  }
+  for (uint32_t count : board.tile_population()) {
+    tiles += count;
+  }
+  if (rows != board.population() || tiles != board.population() ||
+      board.tile_population().size() != 3 * 4) {
+    throw std::runtime_error("Rows or tiles do not add up");
+  }
+  BoundingBox box = board.bounding_box();
+  if (box.x_min < 40 || box.x_max >= 110 || box.y_min < 50 ||
+      box.y_max >= 130) {
+    throw std::runtime_error("Bounding box is too large");
+  }
+  std::cout << "statistics_test passed!" << std::endl;
+}
+
+// test 4: the metrics of a run add up
+void metrics_test() {
+  // A block on a large empty board: after the first generation only the
+  // tiles around it are recomputed
+  TiledGameBoard board(512, 512);
+  for (int x = 100; x < 102; x++) {
+    for (int y = 100; y < 102; y++) {
+      board.set_cell_state(x, y, true);
+    }
+  }
+  Metrics metrics(2);
+  for (int i = 0; i < 10; i++) {
+    int64_t start = profile_clock_ns();
+    board.update();
+    metrics.record_generation(board, profile_clock_ns() - start);
+  }
+  if (metrics.generations() != 10 || metrics.update_latency().count() != 10 ||
+      metrics.compute_latency().count() != 10) {
+    throw std::runtime_error("Wrong number of generations");
+  }
+  if (metrics.population() != 4 || metrics.active_cells() != 0 ||
+      metrics.mem_usage() != board.report_mem_usage()) {
+    throw std::runtime_error("Wrong board samples");
+  }
+  if (metrics.compute_latency().max() > metrics.update_latency().max()) {
+    throw std::runtime_error("Compute took longer than update()");
+  }
+  // The threaded board reports the time spent waiting for its threads
+  FullyOptimizedGameBoard threaded(256, 256, 4);
+  threaded.update();
+  if (threaded.last_update_profile().sync_ns < 0) {
+    throw std::runtime_error("Negative sync time");
+  }
+  std::string json = metrics.to_json();
+  for (const char* key : {"\"update\"", "\"compute\"", "\"swap\"", "\"sync\"",
+                          "\"p99_us\"", "\"population\": 4"}) {
+    if (json.find(key) == std::string::npos) {
+      throw std::runtime_error(std::string("Missing ") + key + " in " + json);
+    }
+  }
+  std::cout << "metrics_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  histogram_test();
+  population_test();
+  statistics_test();
+  metrics_test();
+  std::cout << "All tests passed" << std::endl;
+}
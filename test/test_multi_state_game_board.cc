@@ -0,0 +1,116 @@
+#include "multi_state_game_board.hh"
+#include "test_harness.hh"
+
+// test 1: a Life-like rule behaves exactly like GameBoard
+void life_test(const std::string& rule, int x_size, int y_size, int rounds) {
+  std::vector<bool> vec(x_size * y_size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    if (rand() < RAND_MAX / 2) {
+      vec[i] = true;
+    }
+  }
+  MultiStateRule multi_state_rule = MultiStateRule::parse(rule);
+  GameBoard game_board(x_size, y_size, multi_state_rule.to_life_like());
+  MultiStateGameBoard multi_state_board(x_size, y_size, multi_state_rule);
+  game_board.read_state_from(vec);
+  multi_state_board.read_state_from(vec);
+  GameBoardTester tester(&game_board, &multi_state_board);
+  tester.run(rounds, {});
+  std::cout << tester.report_cpu_time() << std::endl;
+  std::cout << "life_test " << rule << " passed!" << std::endl;
+}
+
+// The next generation of `cells` straight from the definition of the rule
+std::vector<uint8_t> reference_update(const MultiStateRule& rule, int x_size,
+                                      int y_size,
+                                      const std::vector<uint8_t>& cells) {
+  std::vector<uint8_t> next(cells.size());
+  const int r = rule.radius();
+  for (int x = 0; x < x_size; x++) {
+    for (int y = 0; y < y_size; y++) {
+      int count = 0;
+      for (int i = x - r; i <= x + r; i++) {
+        for (int j = y - r; j <= y + r; j++) {
+          bool self = i == x && j == y;
+          if (i >= 0 && i < x_size && j >= 0 && j < y_size &&
+              (!self || rule.counts_center())) {
+            count += cells[i * y_size + j] == 1;
+          }
+        }
+      }
+      uint8_t state = cells[x * y_size + y];
+      uint8_t& out = next[x * y_size + y];
+      if (state == 0) {
+        out = rule.births(count);
+      } else if (state == 1) {
+        out = rule.survives(count) ? 1 : (rule.states() > 2 ? 2 : 0);
+      } else {
+        out = (state + 1) % rule.states();
+      }
+    }
+  }
+  return next;
+}
+
+// test 2: Generations and Larger than Life rules match the reference
+void reference_test(const std::string& rule, int x_size, int y_size,
+                    int rounds) {
+  MultiStateRule multi_state_rule = MultiStateRule::parse(rule);
+  MultiStateGameBoard board(x_size, y_size, multi_state_rule);
+  std::vector<uint8_t> cells(x_size * y_size);
+  for (int x = 0; x < x_size; x++) {
+    for (int y = 0; y < y_size; y++) {
+      cells[x * y_size + y] = rand() % multi_state_rule.states();
+      board.set_state(x, y, cells[x * y_size + y]);
+    }
+  }
+  for (int round = 0; round < rounds; round++) {
+    board.update();
+    cells = reference_update(multi_state_rule, x_size, y_size, cells);
+    for (int x = 0; x < x_size; x++) {
+      for (int y = 0; y < y_size; y++) {
+        if (board.get_state(x, y) != cells[x * y_size + y]) {
+          throw std::runtime_error(rule + ": wrong state at (" +
+                                   std::to_string(x) + ", " +
+                                   std::to_string(y) + ") in round " +
+                                   std::to_string(round));
+        }
+      }
+    }
+  }
+  std::cout << "reference_test " << rule << " passed!" << std::endl;
+}
+
+// test 3: get_rule() only works for Life-like rules
+void get_rule_test() {
+  MultiStateGameBoard life(10, 10, Rule::parse("B36/S23"));
+  if (life.get_rule() != Rule::parse("B36/S23")) {
+    throw std::runtime_error("Wrong Life-like rule");
+  }
+  MultiStateGameBoard brain(10, 10, MultiStateRule::parse("B2/S/C3"));
+  try {
+    brain.get_rule();
+    throw std::runtime_error("B2/S/C3 returned a Life-like rule");
+  } catch (const std::logic_error&) {
+  }
+  std::cout << "get_rule_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  life_test("B3/S23", 256, 256, 100);
+  life_test("B36/S23", 130, 100, 50);
+  // Life written as a Larger than Life rule
+  life_test("R1,C0,M0,S2..3,B3..3,NM", 130, 100, 50);
+  // Brian's Brain and Star Wars
+  reference_test("B2/S/C3", 100, 70, 30);
+  reference_test("B2/S345/C4", 100, 70, 30);
+  // Bosco's Rule and Majority, with the cell itself counted
+  reference_test("R5,C0,M1,S34..58,B34..45,NM", 100, 70, 30);
+  reference_test("R4,C0,M1,S41..81,B41..81,NM", 100, 70, 30);
+  // Larger than Life with dying states, on a board smaller than the window
+  reference_test("R2,C4,M0,S3..8,B4..6,NM", 100, 70, 30);
+  reference_test("R7,C3,M0,S20..60,B30..40,NM", 12, 9, 20);
+  get_rule_test();
+  std::cout << "All tests passed" << std::endl;
+}
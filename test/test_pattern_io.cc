@@ -0,0 +1,233 @@
+#include "pattern_io.hh"
+
+#include <sstream>
+
+#include "board_factory.hh"
+#include "test_harness.hh"
+
+// Gosper glider gun from the LifeWiki, wrapped over several lines
+const char* kGosperGun =
+    "#N Gosper glider gun\n"
+    "#C The first known gun\n"
+    "x = 36, y = 9, rule = B3/S23\n"
+    "24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4b\n"
+    "obo$10bo5bo7bo$11bo3bo$12b2o!\n";
+
+// The same gun as plaintext
+const char* kGosperGunCells =
+    "!Name: Gosper glider gun\n"
+    "........................O\n"
+    "......................O.O\n"
+    "............OO......OO............OO\n"
+    "...........O...O....OO............OO\n"
+    "OO........O.....O...OO\n"
+    "OO........O...O.OO....O.O\n"
+    "..........O.....O.......O\n"
+    "...........O...O\n"
+    "............OO\n";
+
+// Place the plaintext `cells` on `board` with set_cell_state(), dropping the
+// cells outside of the board
+void place(AbstractGameBoard& board, const std::string& cells, int x, int y) {
+  int x_size, y_size;
+  std::tie(x_size, y_size) = board.get_board_size();
+  std::stringstream in(cells);
+  std::string line;
+  int row = 0;
+  while (std::getline(in, line)) {
+    if (line[0] == '!') {
+      continue;
+    }
+    for (int column = 0; column < static_cast<int>(line.size()); column++) {
+      if (line[column] == 'O' && x + row < x_size && y + column < y_size) {
+        board.set_cell_state(x + row, y + column, true);
+      }
+    }
+    row++;
+  }
+}
+
+// test 1: both formats place the same cells as set_cell_state() on every
+// engine, also at offsets crossing word boundaries
+void load_test() {
+  const int x_size = 100, y_size = 150;
+  for (const EngineInfo& engine : engines()) {
+    for (std::pair<int, int> at : {std::make_pair(0, 0), {7, 60}, {50, 100}}) {
+      GameBoard expected(x_size, y_size);
+      place(expected, kGosperGunCells, at.first, at.second);
+      std::unique_ptr<AbstractGameBoard> rle =
+          make_game_board(engine.name, x_size, y_size);
+      std::unique_ptr<AbstractGameBoard> cells =
+          make_game_board(engine.name, x_size, y_size);
+      std::stringstream rle_in(kGosperGun), cells_in(kGosperGunCells);
+      PatternInfo info = read_rle(rle_in, *rle, at.first, at.second);
+      read_plaintext(cells_in, *cells, at.first, at.second);
+      if (*rle != expected || *cells != expected) {
+        throw std::runtime_error(std::string(engine.name) +
+                                 ": pattern placed wrong");
+      }
+      if (info.width != 36 || info.height != 9 || info.rule != "B3/S23" ||
+          info.live_cells != 36 || info.clipped_cells != 0 ||
+          rle->population() != 36) {
+        throw std::runtime_error(std::string(engine.name) +
+                                 ": wrong pattern info");
+      }
+    }
+  }
+  std::cout << "load_test passed!" << std::endl;
+}
+
+// test 2: cells outside of the board are clipped and live cells are added to
+// the board
+void clip_test() {
+  GameBoard expected(20, 30), board(20, 30);
+  expected.set_cell_state(0, 0, true);
+  board.set_cell_state(0, 0, true);
+  place(expected, kGosperGunCells, 15, 10);
+  std::stringstream in(kGosperGun);
+  PatternInfo info = read_rle(in, board, 15, 10);
+  if (board != expected) {
+    throw std::runtime_error("Clipped pattern placed wrong");
+  }
+  if (info.live_cells + info.clipped_cells != 36 ||
+      info.live_cells != board.population() - 1) {
+    throw std::runtime_error("Clipped cells not counted");
+  }
+  // Negative offsets clip the top left
+  GameBoard negative(20, 30), negative_expected(20, 30);
+  std::stringstream negative_in(kGosperGun);
+  info = read_rle(negative_in, negative, -3, -20);
+  GameBoard full(40, 60);
+  std::stringstream full_in(kGosperGun);
+  read_rle(full_in, full, 0, 0);
+  for (int x = 3; x < 9; x++) {
+    for (int y = 20; y < 36; y++) {
+      negative_expected.set_cell_state(x - 3, y - 20,
+                                       full.get_cell_state(x, y));
+    }
+  }
+  if (negative != negative_expected ||
+      info.live_cells != negative.population()) {
+    throw std::runtime_error("Negative offset placed wrong");
+  }
+  std::cout << "clip_test passed!" << std::endl;
+}
+
+// test 3: a saved board loads back to the same cells, and the saved RLE keeps
+// its lines short
+void save_test() {
+  const int x_size = 90, y_size = 200;
+  std::vector<bool> vec(x_size * y_size);
+  for (int x = 10; x < 80; x++) {
+    for (int y = 5; y < 190; y++) {
+      vec[x * y_size + y] = rand() < RAND_MAX / 3;
+    }
+  }
+  BitSlicedGameBoard board(x_size, y_size);
+  board.read_state_from(vec);
+  for (bool rle : {true, false}) {
+    std::stringstream out;
+    rle ? write_rle(out, board) : write_plaintext(out, board, "soup");
+    const BoundingBox box = board.bounding_box();
+    BitSlicedGameBoard loaded(x_size, y_size);
+    PatternInfo info = rle ? read_rle(out, loaded, box.x_min, box.y_min)
+                           : read_plaintext(out, loaded, box.x_min, box.y_min);
+    if (loaded != board || info.live_cells != board.population() ||
+        info.width != box.y_max - box.y_min + 1 ||
+        info.height != box.x_max - box.x_min + 1) {
+      throw std::runtime_error(std::string(rle ? "RLE" : "Plaintext") +
+                               " did not round trip");
+    }
+    std::string line;
+    out.clear();
+    out.seekg(0);
+    while (rle && std::getline(out, line)) {
+      if (line.size() > 70) {
+        throw std::runtime_error("RLE line longer than 70 characters");
+      }
+    }
+  }
+  // The rule goes into the header
+  BitSlicedGameBoard highlife(10, 10, Rule::parse("B36/S23"));
+  highlife.set_cell_state(3, 4, true);
+  std::stringstream out;
+  write_rle(out, highlife);
+  if (out.str() != "x = 1, y = 1, rule = B36/S23\no!\n") {
+    throw std::runtime_error("Unexpected RLE " + out.str());
+  }
+  // An empty board
+  GameBoard empty(10, 10);
+  out.str("");
+  write_rle(out, empty);
+  if (out.str() != "x = 0, y = 0, rule = B3/S23\n!\n") {
+    throw std::runtime_error("Unexpected RLE of an empty board " + out.str());
+  }
+  std::cout << "save_test passed!" << std::endl;
+}
+
+// test 4: malformed input is rejected, with the line it was found on
+void malformed_test() {
+  for (const char* rle : {"x = 3, y = 1\n3o\n2q!", "x = 3, z = 1\no!",
+                          "x = -3, y = 1\no!", "99999999999o!"}) {
+    GameBoard board(10, 10);
+    std::stringstream in(rle);
+    try {
+      read_rle(in, board);
+      throw std::runtime_error(std::string("Accepted ") + rle);
+    } catch (const std::invalid_argument& e) {
+    }
+  }
+  GameBoard board(10, 10);
+  std::stringstream in("x = 3, y = 1\n3o\n2q!");
+  try {
+    read_rle(in, board);
+  } catch (const std::invalid_argument& e) {
+    if (std::string(e.what()).find("line 3") == std::string::npos) {
+      throw std::runtime_error(std::string("Wrong line in ") + e.what());
+    }
+  }
+  std::stringstream cells("!comment\n.O.\nOxO\n");
+  try {
+    read_plaintext(cells, board);
+    throw std::runtime_error("Accepted a malformed plaintext pattern");
+  } catch (const std::invalid_argument& e) {
+  }
+  try {
+    pattern_format_of("glider.mc");
+    throw std::runtime_error("Accepted a .mc file");
+  } catch (const std::invalid_argument& e) {
+  }
+  std::cout << "malformed_test passed!" << std::endl;
+}
+
+// test 5: rows far wider than the board are streamed and clipped
+void stream_test() {
+  std::stringstream in;
+  in << "x = 200000, y = 2\n";
+  for (int i = 0; i < 100000; i++) {
+    in << "bo";
+    if (i % 30 == 29) {
+      in << "\n";
+    }
+  }
+  in << "$" << 200000 << "o!";
+  std::unique_ptr<AbstractGameBoard> board =
+      make_game_board("sparse", 64, 1000);
+  PatternInfo info = read_rle(in, *board, 5, 0);
+  if (info.live_cells != 500 + 1000 ||
+      info.clipped_cells != 99500 + 199000 || board->get_cell_state(5, 0) ||
+      !board->get_cell_state(5, 1) || !board->get_cell_state(6, 999)) {
+    throw std::runtime_error("Long rows placed wrong");
+  }
+  std::cout << "stream_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  load_test();
+  clip_test();
+  save_test();
+  malformed_test();
+  stream_test();
+  std::cout << "All tests passed" << std::endl;
+}
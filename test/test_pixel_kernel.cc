@@ -0,0 +1,126 @@
+#include "pixel_kernel.hh"
+
+#include "test_harness.hh"
+
+const uint32_t kAlive = 0xFFFFFFFF, kDead = 0xFF000000;
+
+// test 1: transpose64() swaps rows and columns
+void transpose_test() {
+  uint64_t block[64], original[64];
+  for (int i = 0; i < 64; i++) {
+    original[i] = block[i] =
+        (uint64_t(rand()) << 33) ^ (uint64_t(rand()) << 11) ^ rand();
+  }
+  transpose64(block);
+  for (int i = 0; i < 64; i++) {
+    for (int j = 0; j < 64; j++) {
+      if ((block[j] >> i & 1) != (original[i] >> j & 1)) {
+        throw std::runtime_error("Bit " + std::to_string(i) + ", " +
+                                 std::to_string(j) + " not transposed");
+      }
+    }
+  }
+  std::cout << "transpose_test passed!" << std::endl;
+}
+
+// test 2: every pixel of a region is the color of its cell, also for
+// regions crossing the edges of the board
+void render_test() {
+  const int x_size = 150, y_size = 100;
+  std::vector<bool> vec(x_size * y_size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    vec[i] = rand() < RAND_MAX / 2;
+  }
+  GameBoard naive(x_size, y_size);
+  BitSlicedGameBoard bitmap(x_size, y_size);
+  naive.read_state_from(vec);
+  bitmap.read_state_from(vec);
+  struct Region {
+    int x0, y0, width, height;
+  };
+  for (Region r : {Region{0, 0, x_size, y_size}, Region{3, 70, 100, 21},
+                   Region{-10, -5, 200, 130}, Region{140, 90, 5, 5},
+                   Region{200, 0, 10, 10}}) {
+    for (const AbstractGameBoard* board :
+         std::vector<const AbstractGameBoard*>{&naive, &bitmap}) {
+      const int pitch = r.width + 7;  // Pixels past the width stay untouched
+      std::vector<uint32_t> pixels(size_t(pitch) * r.height, 42);
+      render_cells(*board, r.x0, r.y0, r.width, r.height, pixels.data(),
+                   pitch, kAlive, kDead);
+      for (int py = 0; py < r.height; py++) {
+        for (int px = 0; px < pitch; px++) {
+          const int x = r.x0 + px, y = r.y0 + py;
+          uint32_t expected =
+              px >= r.width ? 42
+              : x >= 0 && x < x_size && y >= 0 && y < y_size &&
+                      naive.get_cell_state(x, y)
+                  ? kAlive
+                  : kDead;
+          if (pixels[py * pitch + px] != expected) {
+            throw std::runtime_error("Wrong pixel " + std::to_string(px) +
+                                     ", " + std::to_string(py));
+          }
+        }
+      }
+    }
+  }
+  std::cout << "render_test passed!" << std::endl;
+}
+
+// test 3: every cell of a downsampled region is the OR of its block, for
+// every engine and for regions crossing the edges of the board
+void downsample_test() {
+  const int x_size = 300, y_size = 200;
+  std::vector<bool> vec(x_size * y_size);
+  for (uint64_t i = 0; i < vec.size(); i++) {
+    vec[i] = rand() < RAND_MAX / 50;
+  }
+  GameBoard naive(x_size, y_size);
+  BitSlicedGameBoard bitmap(x_size, y_size);
+  naive.read_state_from(vec);
+  bitmap.read_state_from(vec);
+  struct Region {
+    int x0, y0, shift, width, height;
+  };
+  for (Region r : {Region{0, 0, 0, x_size, y_size}, Region{-7, 13, 0, 90, 150},
+                   Region{5, -70, 1, 100, 130}, Region{-3, 3, 3, 40, 30},
+                   Region{-100, -100, 5, 9, 11}, Region{2, 1, 6, 5, 4},
+                   Region{-200, -150, 7, 4, 3}, Region{400, 0, 2, 10, 10}}) {
+    for (const AbstractGameBoard* board :
+         std::vector<const AbstractGameBoard*>{&naive, &bitmap}) {
+      TwoDimBitMap out(r.width, r.height);
+      out.set(0, 0);  // Overwritten
+      downsample(*board, r.x0, r.y0, r.shift, out);
+      const int block = 1 << r.shift;
+      for (int i = 0; i < r.width; i++) {
+        for (int j = 0; j < r.height; j++) {
+          bool expected = false;
+          for (int x = r.x0 + i * block; x < r.x0 + (i + 1) * block; x++) {
+            for (int y = r.y0 + j * block; y < r.y0 + (j + 1) * block; y++) {
+              expected |= x >= 0 && x < x_size && y >= 0 && y < y_size &&
+                          naive.get_cell_state(x, y);
+            }
+          }
+          if (out.get(i, j) != expected) {
+            throw std::runtime_error(
+                "Wrong cell " + std::to_string(i) + ", " + std::to_string(j) +
+                " at shift " + std::to_string(r.shift));
+          }
+        }
+        // The padding bits stay clear
+        if (r.height % 64 && out.row(i)[r.height / 64] >> (r.height % 64)) {
+          throw std::runtime_error("Padding bits set");
+        }
+      }
+    }
+  }
+  std::cout << "downsample_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  transpose_test();
+  render_test();
+  downsample_test();
+  std::cout << "All tests passed" << std::endl;
+}
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "rule.hh"
+
+// Tests must not depend on assert(), which is compiled out in Release builds
+void check(bool condition, const std::string& what) {
+  if (!condition) {
+    throw std::runtime_error("Check failed: " + what);
+  }
+}
+
+// test 1: well-formed rules
+void parse_test() {
+  Rule life = Rule::parse("B3/S23");
+  check(life == Rule() && life == Rule(LifeRule()), "B3/S23 is Life");
+  check(life.birth() == 1 << 3, "Life birth mask");
+  check(life.survival() == (1 << 2 | 1 << 3), "Life survival mask");
+  // Lower case letters, and the survival part first
+  check(Rule::parse("b36/s23") == Rule(HighLifeRule()), "b36/s23");
+  check(Rule::parse("S34678/B3678") == Rule(DayAndNightRule()),
+        "S34678/B3678");
+  // No survival at all
+  check(Rule::parse("B2/S") == Rule(SeedsRule()), "B2/S");
+  check(Rule::parse("B0/S8").births_from_nothing(), "B0/S8 has B0");
+  check(!life.births_from_nothing(), "B3/S23 has no B0");
+  std::cout << "parse_test passed!" << std::endl;
+}
+
+// test 2: malformed rules are rejected
+void invalid_test() {
+  for (const char* rule :
+       {"", "B3S23", "3/23", "B3/S23/", "B9/S23", "B3/B23", "B3/Sx", "/S23"}) {
+    try {
+      Rule::parse(rule);
+      throw std::runtime_error(std::string("Accepted invalid rule ") + rule);
+    } catch (const std::invalid_argument&) {
+    }
+  }
+  std::cout << "invalid_test passed!" << std::endl;
+}
+
+// test 3: rules are printed in B/S notation
+void to_string_test() {
+  for (const char* rule : {"B3/S23", "B36/S23", "B3678/S34678", "B2/S",
+                           "B012345678/S012345678", "B/S"}) {
+    if (Rule::parse(rule).to_string() != rule) {
+      throw std::runtime_error(std::string("Wrong round trip of ") + rule);
+    }
+  }
+  std::cout << "to_string_test passed!" << std::endl;
+}
+
+// test 4: next_state follows the masks
+void next_state_test() {
+  Rule high_life = Rule::parse("B36/S23");
+  for (int n = 0; n <= 8; n++) {
+    check(high_life.next_state(false, n) == (n == 3 || n == 6),
+          "HighLife birth with " + std::to_string(n) + " neighbours");
+    check(high_life.next_state(true, n) == (n == 2 || n == 3),
+          "HighLife survival with " + std::to_string(n) + " neighbours");
+  }
+  std::cout << "next_state_test passed!" << std::endl;
+}
+
+// test 5: multi-state rules in Generations and Larger than Life notation
+void multi_state_test() {
+  MultiStateRule brain = MultiStateRule::parse("B2/S/C3");
+  check(brain.states() == 3 && brain.radius() == 1, "B2/S/C3");
+  check(brain.births(2) && !brain.births(3) && !brain.survives(2),
+        "B2/S/C3 counts");
+  check(!brain.is_life_like(), "B2/S/C3 is not Life-like");
+  // Without a C part, and with the C part in the middle
+  check(MultiStateRule::parse("B3/S23").to_life_like() == Rule(), "B3/S23");
+  check(MultiStateRule::parse("B2/C4/S345") ==
+            MultiStateRule::parse("B2/S345/C4"),
+        "B2/C4/S345");
+  MultiStateRule bosco = MultiStateRule::parse("R5,C0,M1,S34..58,B34..45,NM");
+  check(bosco.radius() == 5 && bosco.states() == 2 && bosco.counts_center(),
+        "Bosco's Rule");
+  check(bosco.max_count() == 121, "Bosco's Rule max count");
+  check(bosco.births(34) && bosco.births(45) && !bosco.births(46),
+        "Bosco's Rule birth range");
+  check(MultiStateRule::parse("R1,C0,M0,S2..3,B3..3,NM") ==
+            MultiStateRule(Rule()),
+        "Life in Larger than Life notation");
+  for (const char* rule :
+       {"B2/S/C3", "B2/S345/C4", "R5,C0,M1,S34..58,B34..45,NM",
+        "R2,C4,M0,S3..8,B4..6,NM"}) {
+    check(MultiStateRule::parse(rule).to_string() == rule,
+          std::string("Round trip of ") + rule);
+  }
+  for (const char* rule :
+       {"B2/S/C1", "B2/S/C", "B2/S/C300", "B2/SC3", "R0,C0,M0,S1..2,B1..2,NM",
+        "R2,C0,M0,S1..2", "R2,C0,M2,S1..2,B1..2,NM", "R1,C0,M0,S1..9,B1..2,NM",
+        "R2,C0,M0,S3..1,B1..2,NM", "R2,C0,M0,S1..2,B1..2,NN", "R2,,S1..2,B1"}) {
+    try {
+      MultiStateRule::parse(rule);
+      throw std::runtime_error(std::string("Accepted invalid rule ") + rule);
+    } catch (const std::invalid_argument&) {
+    }
+  }
+  std::cout << "multi_state_test passed!" << std::endl;
+}
+
+int main() {
+  parse_test();
+  invalid_test();
+  to_string_test();
+  next_state_test();
+  multi_state_test();
+  std::cout << "All tests passed" << std::endl;
+}
@@ -0,0 +1,165 @@
+#include "snapshot.hh"
+
+#include <cstdio>
+#include <fstream>
+
+#include "board_factory.hh"
+#include "test_harness.hh"
+
+const char* kPath = "test_snapshot.snap";
+
+// A random soup in the middle of the board, away from the edges where the
+// unbounded sparse board differs
+std::vector<bool> central_soup(int x_size, int y_size) {
+  std::vector<bool> vec(x_size * y_size);
+  for (int x = x_size / 4; x < x_size * 3 / 4; x++) {
+    for (int y = y_size / 4; y < y_size * 3 / 4; y++) {
+      vec[x * y_size + y] = rand() < RAND_MAX / 2;
+    }
+  }
+  return vec;
+}
+
+// test 1: every engine restores the snapshots of every engine in both
+// layouts, and the restored board evolves like the original
+void round_trip_test(int x_size, int y_size) {
+  const Rule highlife = Rule::parse("B36/S23");
+  std::vector<bool> vec = central_soup(x_size, y_size);
+  GameBoard reference(x_size, y_size, highlife);
+  reference.read_state_from(vec);
+  for (const EngineInfo& engine : engines()) {
+    for (bool tiles : {false, true}) {
+      std::unique_ptr<AbstractGameBoard> board =
+          make_game_board(engine.name, x_size, y_size, highlife);
+      board->read_state_from(vec);
+      save_snapshot(kPath, *board, 1234, tiles);
+
+      SnapshotInfo info = read_snapshot_info(kPath);
+      if (info.x_size != x_size || info.y_size != y_size ||
+          info.rule != highlife || info.generation != 1234 ||
+          info.tiles != tiles) {
+        throw std::runtime_error(std::string(engine.name) +
+                                 ": wrong snapshot header");
+      }
+      std::unique_ptr<AbstractGameBoard> loaded =
+          make_game_board(engine.name, x_size, y_size, info.rule);
+      loaded->set_cell_state(0, 0, true);  // Replaced by the snapshot
+      load_snapshot(kPath, *loaded);
+      if (*loaded != reference || loaded->population() !=
+                                      reference.population()) {
+        throw std::runtime_error(std::string(engine.name) +
+                                 " did not restore its snapshot");
+      }
+      GameBoard copy = reference;
+      GameBoardTester tester(&copy, loaded.get());
+      tester.run(5, {});
+
+      // The generic board restores snapshots of any board
+      GameBoard naive(x_size, y_size, highlife);
+      load_snapshot(kPath, naive);
+      if (naive != reference) {
+        throw std::runtime_error(std::string(engine.name) +
+                                 ": snapshot unreadable by GameBoard");
+      }
+    }
+  }
+  std::remove(kPath);
+  std::cout << "round_trip_test " << x_size << "x" << y_size << " passed!"
+            << std::endl;
+}
+
+// test 2: a mapped snapshot is private to the board, and tiled snapshots of
+// sparse boards are small
+void mapping_test() {
+  const int x_size = 512, y_size = 512;
+  BitSlicedGameBoard board(x_size, y_size);
+  board.set_cell_state(100, 100, true);
+  board.set_cell_state(100, 101, true);
+  board.set_cell_state(100, 102, true);
+  save_snapshot(kPath, board, 7);
+  std::ifstream raw(kPath, std::ios::binary | std::ios::ate);
+  const long raw_size = raw.tellg();
+
+  BitSlicedGameBoard first(x_size, y_size), second(x_size, y_size);
+  load_snapshot(kPath, first);
+  load_snapshot(kPath, second);
+  // Writes and generations of one board touch neither the file nor the
+  // other board
+  first.set_cell_state(0, 0, true);
+  first.update();
+  if (second != board || second.get_cell_state(0, 0)) {
+    throw std::runtime_error("Boards share a mapped snapshot");
+  }
+  BitSlicedGameBoard third(x_size, y_size);
+  load_snapshot(kPath, third);
+  if (third != board) {
+    throw std::runtime_error("The snapshot was written through the mapping");
+  }
+  // The blinker keeps blinking on the mapped buffers
+  for (int i = 0; i < 4; i++) {
+    third.update();
+  }
+  if (third != board) {
+    throw std::runtime_error("Mapped board evolved wrong");
+  }
+
+  save_snapshot(kPath, board, 7, true);
+  std::ifstream tiled(kPath, std::ios::binary | std::ios::ate);
+  const long tiled_size = tiled.tellg();
+  // The header page, the tile mask and one tile
+  if (tiled_size != 4096 + 8 + 64 * 8 || tiled_size * 10 > raw_size) {
+    throw std::runtime_error("Tiled snapshot of " +
+                             std::to_string(tiled_size) + " bytes");
+  }
+  std::remove(kPath);
+  std::cout << "mapping_test passed!" << std::endl;
+}
+
+// test 3: broken snapshots and boards of another size are rejected
+void error_test() {
+  GameBoard board(64, 64);
+  save_snapshot(kPath, board, 0);
+  GameBoard other(64, 65);
+  try {
+    load_snapshot(kPath, other);
+    throw std::runtime_error("Loaded a snapshot of another size");
+  } catch (const std::invalid_argument&) {
+  }
+  // Truncated
+  std::ifstream in(kPath, std::ios::binary);
+  std::string bytes((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  in.close();
+  for (size_t size : {size_t(0), size_t(10), size_t(4096), bytes.size() - 8}) {
+    std::ofstream(kPath, std::ios::binary) << bytes.substr(0, size);
+    try {
+      load_snapshot(kPath, board);
+      throw std::runtime_error("Loaded a truncated snapshot of " +
+                               std::to_string(size) + " bytes");
+    } catch (const std::runtime_error& e) {
+      if (std::string(e.what()).find("not a valid snapshot") ==
+          std::string::npos) {
+        throw;
+      }
+    }
+  }
+  std::remove(kPath);
+  try {
+    read_snapshot_info(kPath);
+    throw std::runtime_error("Read a missing snapshot");
+  } catch (const std::runtime_error& e) {
+    if (std::string(e.what()).find("Cannot open") == std::string::npos) {
+      throw;
+    }
+  }
+  std::cout << "error_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  round_trip_test(130, 200);
+  round_trip_test(33, 17);
+  mapping_test();
+  error_test();
+  std::cout << "All tests passed" << std::endl;
+}
@@ -0,0 +1,143 @@
+#include "sparse_game_board.hh"
+#include "test_harness.hh"
+
+// test 1: update() matches GameBoard while the pattern stays clear of the
+// edge of the board
+void update_test() {
+  const int size = 512;
+  // A random soup in the center, it cannot reach the edge within 200 rounds
+  std::vector<bool> vec(size * size);
+  for (int x = size / 2 - 32; x < size / 2 + 32; x++) {
+    for (int y = size / 2 - 40; y < size / 2 + 24; y++) {
+      if (rand() < RAND_MAX / 2) {
+        vec[x * size + y] = true;
+      }
+    }
+  }
+  GameBoard game_board(size, size);
+  SparseGameBoard sparse_board(size, size);
+  game_board.read_state_from(vec);
+  sparse_board.read_state_from(vec);
+  GameBoardTester tester(&game_board, &sparse_board);
+  tester.run(200, {});
+  std::cout << tester.report_cpu_time() << std::endl;
+  std::cout << "update_test passed!" << std::endl;
+}
+
+// test 2: a glider keeps flying far beyond the window, into negative
+// coordinates, while the board only holds the few chunks around it
+void glider_test() {
+  SparseGameBoard board(64, 64);
+  // Glider heading towards decreasing x and y
+  board.set_cell_state(20, 20, true);
+  board.set_cell_state(20, 21, true);
+  board.set_cell_state(20, 22, true);
+  board.set_cell_state(21, 20, true);
+  board.set_cell_state(22, 21, true);
+
+  // Every 4 generations the glider moves one cell diagonally
+  const int shift = 1000;
+  size_t max_chunks = 0;
+  for (int i = 0; i < 4 * shift; i++) {
+    board.update();
+    max_chunks = std::max(max_chunks, board.chunk_count());
+  }
+  for (auto [x, y] : {std::make_pair(20, 20), std::make_pair(20, 21),
+                      std::make_pair(20, 22), std::make_pair(21, 20),
+                      std::make_pair(22, 21)}) {
+    if (!board.get_cell_state(x - shift, y - shift)) {
+      throw std::runtime_error("The glider is not where it should be");
+    }
+  }
+  for (int x = 0; x < 64; x++) {
+    for (int y = 0; y < 64; y++) {
+      if (board.get_cell_state(x, y)) {
+        throw std::runtime_error("The glider left cells behind");
+      }
+    }
+  }
+  // A glider touches at most 4 chunks, plus the neighbours it may be born
+  // into. A dense board over the bounding box would need (2 * shift)^2 bits.
+  if (max_chunks > 9) {
+    throw std::runtime_error("Too many chunks: " + std::to_string(max_chunks));
+  }
+  std::cout << "Memory usage of the glider: " << board.report_mem_usage()
+            << " bytes" << std::endl;
+  std::cout << "glider_test passed!" << std::endl;
+}
+
+// test 3: chunks that die out are returned
+void free_test() {
+  SparseGameBoard board(256, 256);
+  // Lonely cells in different chunks, all of them die in one generation
+  for (int i = -5; i < 5; i++) {
+    board.set_cell_state(i * 100, i * 70, true);
+  }
+  if (board.chunk_count() != 10) {
+    throw std::runtime_error("Expected one chunk per cell");
+  }
+  board.update();
+  if (board.chunk_count() != 0) {
+    throw std::runtime_error("Dead chunks were not freed");
+  }
+
+  // Many lonely cells around a block: the memory of their chunks is given
+  // back once they die, and the block survives the move to a smaller pool
+  for (int i = 0; i < 1000; i++) {
+    board.set_cell_state(i * 100, -i * 70, true);
+  }
+  for (int i : {0, 1}) {
+    for (int j : {0, 1}) {
+      board.set_cell_state(i - 500, j - 500, true);
+    }
+  }
+  const int before = board.report_mem_usage();
+  board.update();
+  if (board.report_mem_usage() * 4 > before) {
+    throw std::runtime_error("Memory of dead chunks was not released: " +
+                             std::to_string(board.report_mem_usage()) +
+                             " of " + std::to_string(before) + " bytes");
+  }
+  if (board.population() != 4 || !board.get_cell_state(-499, -499)) {
+    throw std::runtime_error("The block did not survive the compaction");
+  }
+  std::cout << "free_test passed!" << std::endl;
+}
+
+// test 4: other rules, and rules the sparse board cannot run
+void rule_test() {
+  // Seeds and Day & Night grow quickly, so the soup is small and the board
+  // is run for a few rounds only
+  for (const char* rule : {"B36/S23", "B3678/S34678", "B2/S", "B1357/S1357"}) {
+    const int size = 256;
+    std::vector<bool> vec(size * size);
+    for (int x = 120; x < 136; x++) {
+      for (int y = 60; y < 76; y++) {
+        if (rand() < RAND_MAX / 2) {
+          vec[x * size + y] = true;
+        }
+      }
+    }
+    GameBoard game_board(size, size, Rule::parse(rule));
+    SparseGameBoard sparse_board(size, size, Rule::parse(rule));
+    game_board.read_state_from(vec);
+    sparse_board.read_state_from(vec);
+    GameBoardTester tester(&game_board, &sparse_board);
+    tester.run(40, {});
+  }
+  try {
+    SparseGameBoard board(64, 64, Rule::parse("B03/S23"));
+    throw std::runtime_error("SparseGameBoard accepted a rule with B0");
+  } catch (const std::invalid_argument&) {
+  }
+  std::cout << "rule_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  update_test();
+  glider_test();
+  free_test();
+  rule_test();
+  std::cout << "All tests passed" << std::endl;
+}
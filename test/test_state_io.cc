@@ -0,0 +1,124 @@
+#include "board_factory.hh"
+#include "test_harness.hh"
+
+// A random board in the packed layout, with garbage in the bits past the
+// last cell of every row
+std::vector<uint64_t> random_words(int x_size, int y_size) {
+  const int words = (y_size + 63) / 64;
+  std::vector<uint64_t> packed(x_size * words);
+  for (uint64_t& word : packed) {
+    word = (uint64_t(rand()) << 33) ^ (uint64_t(rand()) << 11) ^ rand();
+  }
+  return packed;
+}
+
+// The packed words with the bits past the last cell cleared
+std::vector<uint64_t> masked(std::vector<uint64_t> packed, int y_size) {
+  const int words = (y_size + 63) / 64;
+  if (y_size % 64) {
+    for (size_t i = words - 1; i < packed.size(); i += words) {
+      packed[i] &= (1UL << (y_size % 64)) - 1;
+    }
+  }
+  return packed;
+}
+
+// test 1: every engine imports and exports the packed layout
+void round_trip_test(int x_size, int y_size) {
+  std::vector<uint64_t> packed = random_words(x_size, y_size);
+  GameBoard reference(x_size, y_size);
+  reference.import_words(packed);
+  if (reference.export_words() != masked(packed, y_size)) {
+    throw std::runtime_error("GameBoard did not round trip");
+  }
+  for (const EngineInfo& engine : engines()) {
+    std::unique_ptr<AbstractGameBoard> board =
+        make_game_board(engine.name, x_size, y_size);
+    // Importing replaces whatever was on the board
+    board->set_cell_state(0, 0, true);
+    board->import_words(packed);
+    if (*board != reference ||
+        board->export_words() != masked(packed, y_size)) {
+      throw std::runtime_error(std::string(engine.name) +
+                               " did not round trip");
+    }
+    if (board->population() != reference.population()) {
+      throw std::runtime_error(std::string(engine.name) +
+                               ": wrong population after import");
+    }
+    // The imported board evolves like the reference, apart from the sparse
+    // board whose cells do not stop at the edge
+    if (std::string(engine.name) != "sparse") {
+      GameBoard copy = reference;
+      GameBoardTester tester(&copy, board.get());
+      tester.run(5, {});
+    }
+
+    // Bytes are the words in little-endian order
+    std::vector<uint8_t> bytes(packed.size() * 8);
+    board->export_bytes(bytes.data(), bytes.size());
+    const int words = board->packed_row_words();
+    for (size_t i = 0; i < bytes.size(); i++) {
+      uint64_t word = board->get_word(i / 8 / words, i / 8 % words);
+      if (bytes[i] != uint8_t(word >> (8 * (i % 8)))) {
+        throw std::runtime_error(std::string(engine.name) +
+                                 ": wrong byte order");
+      }
+    }
+    std::unique_ptr<AbstractGameBoard> loaded =
+        make_game_board(engine.name, x_size, y_size);
+    loaded->import_bytes(bytes.data(), bytes.size());
+    if (*loaded != *board) {
+      throw std::runtime_error(std::string(engine.name) +
+                               " did not round trip bytes");
+    }
+  }
+  std::cout << "round_trip_test " << x_size << "x" << y_size << " passed!"
+            << std::endl;
+}
+
+// test 2: set_word() and word-level equality
+void word_test() {
+  const int x_size = 70, y_size = 100;
+  BitSlicedGameBoard a(x_size, y_size), b(x_size, y_size);
+  GameBoard c(x_size, y_size);
+  std::vector<uint64_t> packed = random_words(x_size, y_size);
+  a.import_words(packed);
+  b.import_words(packed);
+  c.import_words(packed);
+  if (a != b || a != c || c != a) {
+    throw std::runtime_error("Equal boards compare unequal");
+  }
+  b.set_cell_state(69, 99, !b.get_cell_state(69, 99));
+  if (a == b) {
+    throw std::runtime_error("Boards differing in one cell compare equal");
+  }
+  c.set_word(69, 1, b.get_word(69, 1));
+  if (b != c) {
+    throw std::runtime_error("set_word() did not set the word");
+  }
+  // The bits past the last cell are ignored
+  b.set_word(3, 1, ~0UL);
+  const uint64_t expected_population =
+      c.population() - __builtin_popcountll(c.get_word(3, 1)) + 36;
+  if (b.get_word(3, 1) != (1UL << 36) - 1 ||
+      b.population() != expected_population) {
+    throw std::runtime_error("set_word() wrote past the last cell");
+  }
+  std::vector<uint8_t> bytes(10);
+  try {
+    a.import_bytes(bytes.data(), bytes.size());
+    throw std::runtime_error("Imported a buffer of the wrong size");
+  } catch (const std::invalid_argument&) {
+  }
+  std::cout << "word_test passed!" << std::endl;
+}
+
+int main() {
+  srand(10808);
+  round_trip_test(130, 200);
+  round_trip_test(64, 64);
+  round_trip_test(33, 17);
+  word_test();
+  std::cout << "All tests passed" << std::endl;
+}